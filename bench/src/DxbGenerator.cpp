@@ -0,0 +1,299 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxbGenerator.hpp"
+
+#include <diannex/DxData.hpp>
+#include <diannex/DxNameIndex.hpp>
+#include <diannex/exceptions.hpp>
+#include <diannex/utils/DxLz.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <zlib.h>
+
+namespace diannex::bench
+{
+    namespace
+    {
+        struct ByteWriter
+        {
+            DxVec<std::byte> buffer{};
+
+            template<class T>
+            void write(T value)
+            {
+                auto offset = buffer.size();
+                buffer.resize(offset + sizeof(T));
+                std::memcpy(buffer.data() + offset, &value, sizeof(T));
+            }
+
+            void write(const DxStrRef& str)
+            {
+                auto offset = buffer.size();
+                buffer.resize(offset + str.size() + 1);
+                std::memcpy(buffer.data() + offset, str.data(), str.size());
+            }
+
+            void write(const DxVec<std::byte>& bytes)
+            { buffer.insert(buffer.end(), bytes.begin(), bytes.end()); }
+
+            /** Starts a section, 4-byte aligned, that runs until `endSection`. */
+            void beginSection(DxSectionType type)
+            {
+                buffer.resize((buffer.size() + 3) & ~(size_t)3);
+                sections.push_back({ type, (uint32_t)buffer.size(), 0 });
+            }
+
+            void endSection()
+            { sections.back().size = (uint32_t)buffer.size() - sections.back().offset; }
+
+            DxVec<DxSection> sections{};
+        };
+    }
+
+    void DxbGenerator::write(const void* data, size_t size)
+    {
+        auto offset = m_code.size();
+        m_code.resize(offset + size);
+        std::memcpy(m_code.data() + offset, data, size);
+    }
+
+    uint32_t DxbGenerator::string(const DxStrRef& str)
+    {
+        auto [it, inserted] = m_stringIndices.try_emplace(DxStr{ str }, (uint32_t)m_strings.size());
+        if (inserted)
+            m_strings.emplace_back(str);
+        return it->second;
+    }
+
+    uint32_t DxbGenerator::translation(const DxStrRef& str)
+    {
+        m_translations.emplace_back(str);
+        return (uint32_t)m_translations.size() - 1;
+    }
+
+    int32_t DxbGenerator::emit(DxOpcode opcode)
+    {
+        auto start = offset();
+        write(&opcode, sizeof(opcode));
+        return start;
+    }
+
+    int32_t DxbGenerator::emit(DxOpcode opcode, int32_t arg)
+    {
+        auto start = emit(opcode);
+        write(&arg, sizeof(arg));
+        return start;
+    }
+
+    int32_t DxbGenerator::emit(DxOpcode opcode, int32_t arg1, int32_t arg2)
+    {
+        auto start = emit(opcode, arg1);
+        write(&arg2, sizeof(arg2));
+        return start;
+    }
+
+    int32_t DxbGenerator::emit(DxOpcode opcode, double arg)
+    {
+        auto start = emit(opcode);
+        write(&arg, sizeof(arg));
+        return start;
+    }
+
+    int32_t DxbGenerator::jump(DxOpcode opcode, int32_t target)
+    {
+        auto start = emit(opcode, 0);
+        patch(start, target);
+        return start;
+    }
+
+    void DxbGenerator::patch(int32_t instruction, int32_t target)
+    {
+        // Relative to the end of the instruction, which is where the program counter is once its argument is read
+        int32_t rel = target - (instruction + (int32_t)(sizeof(DxOpcode) + sizeof(int32_t)));
+        std::memcpy(m_code.data() + instruction + sizeof(DxOpcode), &rel, sizeof(rel));
+    }
+
+    void DxbGenerator::scene(const DxStrRef& name, int32_t codeOffset, DxVec<int32_t> flagOffsets)
+    { m_scenes.push_back({ string(name), codeOffset, std::move(flagOffsets) }); }
+
+    void DxbGenerator::function(const DxStrRef& name, int32_t codeOffset, DxVec<int32_t> flagOffsets)
+    { m_functions.push_back({ string(name), codeOffset, std::move(flagOffsets) }); }
+
+    void DxbGenerator::definition(const DxStrRef& name, const DxStrRef& value, int32_t codeOffset)
+    { m_definitions.push_back({ string(name), string(value) | (1u << 31), codeOffset }); }
+
+    DxVec<std::byte> DxbGenerator::build(DxbCompression compression, bool nameIndex) const
+    {
+        using Type = DxSectionType;
+        ByteWriter body;
+
+        for (const auto& [type, entries]: { std::pair{ Type::Scenes, &m_scenes }, { Type::Functions, &m_functions } })
+        {
+            body.beginSection(type);
+            body.write((uint32_t)entries->size());
+            for (const auto& entry: *entries)
+            {
+                body.write(entry.name);
+                body.write((uint16_t)(1 + entry.flagOffsets.size()));
+                body.write(entry.codeOffset);
+                for (auto flagOffset: entry.flagOffsets)
+                    body.write(flagOffset);
+            }
+            body.endSection();
+        }
+
+        // Sorted by name, as the runtime expects them to be when there's a name index
+        auto definitions = m_definitions;
+        std::sort(definitions.begin(), definitions.end(), [this](const auto& a, const auto& b)
+        { return m_strings[a.name] < m_strings[b.name]; });
+
+        body.beginSection(Type::Definitions);
+        body.write((uint32_t)definitions.size());
+        for (const auto& def: definitions)
+        {
+            body.write(def.name);
+            body.write(def.value);
+            body.write(def.codeOffset);
+        }
+        body.endSection();
+
+        body.beginSection(Type::Bytecode);
+        body.write(m_code);
+        body.endSection();
+
+        for (const auto& [type, strings]: { std::pair{ Type::Strings, &m_strings },
+                                            { Type::Translations, &m_translations } })
+        {
+            body.beginSection(type);
+            body.write((uint32_t)strings->size());
+            for (const auto& str: *strings)
+                body.write(DxStrRef{ str });
+            body.endSection();
+        }
+
+        // No external function list; the runtime doesn't read it
+        body.beginSection(Type::ExternalFunctions);
+        body.write<uint32_t>(0);
+        body.endSection();
+
+        // Translation index: where each translation ends, relative to the first one
+        body.beginSection(Type::TranslationIndex);
+        body.write((uint32_t)m_translations.size());
+        uint32_t end = 0;
+        for (const auto& str: m_translations)
+            body.write(end += (uint32_t)str.size() + 1);
+        body.endSection();
+
+        if (nameIndex)
+        {
+            body.beginSection(Type::NameIndex);
+            DxVec<DxStrRef> names;
+            for (const auto* entries: { &m_scenes, &m_functions })
+            {
+                names.clear();
+                for (const auto& entry: *entries)
+                    names.emplace_back(m_strings[entry.name]);
+                DxNameIndex::build(names, body.buffer);
+            }
+            names.clear();
+            for (const auto& def: definitions)
+                names.emplace_back(m_strings[def.name]);
+            DxNameIndex::build(names, body.buffer);
+            body.endSection();
+        }
+
+        // The section directory goes in front, which keeps the sections aligned since it's a multiple of 4 bytes
+        ByteWriter content;
+        content.write((uint32_t)body.sections.size());
+        auto directorySize = (uint32_t)(sizeof(uint32_t) + body.sections.size() * sizeof(DxSection));
+        for (auto section: body.sections)
+        {
+            section.offset += directorySize;
+            content.write(section);
+        }
+        content.write(body.buffer);
+
+        ByteWriter out;
+        for (char c: { 'D', 'N', 'X' })
+            out.write(c);
+        out.write<uint8_t>(DxData::FormatVersion);
+        // Translations are always internal, indexed
+        out.write<uint8_t>((compression == DxbCompression::Zlib ? 1 : 0) | (1 << 1) | (1 << 2) |
+                           (compression == DxbCompression::Lz ? 1 << 3 : 0));
+        out.write((uint32_t)content.buffer.size());
+
+        if (compression == DxbCompression::Lz)
+        {
+            auto compressed = lz_compress(content.buffer);
+            out.write((uint32_t)compressed.size());
+            out.write(compressed);
+        }
+        else if (compression == DxbCompression::Zlib)
+        {
+            auto compressedSize = compressBound((uLong)content.buffer.size());
+            DxVec<std::byte> temp(compressedSize);
+            if (compress((Bytef*)temp.data(), &compressedSize, (const Bytef*)content.buffer.data(),
+                         (uLong)content.buffer.size()) != Z_OK)
+                throw diannex_exception("Failed to compress generated binary");
+            temp.resize(compressedSize);
+
+            out.write((uint32_t)compressedSize);
+            out.write(temp);
+        }
+        else
+        {
+            out.write(content.buffer);
+        }
+
+        return std::move(out.buffer);
+    }
+
+    void DxbGenerator::save(const DxStrRef& filename, DxbCompression compression, bool nameIndex) const
+    {
+        auto bytes = build(compression, nameIndex);
+        std::ofstream file(DxStr{ filename }, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+        if (!file)
+            throw diannex_exception("Failed to write {}", filename);
+    }
+
+    void DxbGenerator::saveTranslation(const DxStrRef& filename, const DxStrRef& prefix, bool indexed) const
+    {
+        ByteWriter out;
+        for (char c: { 'D', 'X', 'T' })
+            out.write(c);
+        out.write<uint8_t>(indexed ? 1 : 0);
+        out.write((uint32_t)m_translations.size());
+
+        if (indexed)
+        {
+            uint32_t offset = 0;
+            out.write(offset);
+            for (const auto& str: m_translations)
+                out.write(offset += (uint32_t)(prefix.size() + str.size() + 1));
+        }
+        for (const auto& str: m_translations)
+            out.write(DxStrRef{ DxFormat("{}{}", prefix, str) });
+
+        std::ofstream file(DxStr{ filename }, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write((const char*)out.buffer.data(), (std::streamsize)out.buffer.size());
+        if (!file)
+            throw diannex_exception("Failed to write {}", filename);
+    }
+}
@@ -0,0 +1,110 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_BENCH_DXBGENERATOR_HPP
+#define LIBDIANNEX_BENCH_DXBGENERATOR_HPP
+
+#include <diannex/common.hpp>
+#include <diannex/DxInstructions.hpp>
+
+namespace diannex::bench
+{
+    enum class DxbCompression
+    {
+        None,
+        Zlib,
+        /** The in-tree LZ codec, see `lz_compress`. */
+        Lz
+    };
+
+    /**
+     * Writes synthetic Diannex binaries (format version 5) directly, so that the benchmarks don't depend on the
+     * compiler or on checked in sample files.
+     *
+     * Code is emitted in order and every `emit` returns the offset of the instruction it wrote, which is what `jump`
+     * and `patch` take to resolve relative jump targets.
+     */
+    class DxbGenerator
+    {
+        struct Entry
+        {
+            uint32_t name;
+            int32_t codeOffset;
+            DxVec<int32_t> flagOffsets;
+        };
+
+        struct DefinitionEntry
+        {
+            uint32_t name;
+            uint32_t value;
+            int32_t codeOffset;
+        };
+
+        DxVec<DxStr> m_strings{};
+        DxMap<DxStr, uint32_t> m_stringIndices{};
+        DxVec<DxStr> m_translations{};
+        DxVec<std::byte> m_code{};
+        DxVec<Entry> m_scenes{};
+        DxVec<Entry> m_functions{};
+        DxVec<DefinitionEntry> m_definitions{};
+
+        void write(const void* data, size_t size);
+
+    public:
+        /** Index of an internal string, added on first use. */
+        uint32_t string(const DxStrRef& str);
+
+        /** Index of a new translated string, as read by `pushs` and `pushints`. */
+        uint32_t translation(const DxStrRef& str);
+
+        [[nodiscard]] int32_t offset() const
+        { return (int32_t)m_code.size(); }
+
+        int32_t emit(DxOpcode opcode);
+
+        int32_t emit(DxOpcode opcode, int32_t arg);
+
+        int32_t emit(DxOpcode opcode, int32_t arg1, int32_t arg2);
+
+        int32_t emit(DxOpcode opcode, double arg);
+
+        /** Emits a jump-like instruction (`j`, `jt`, `jf`, `choiceadd`, ...) to an offset that is already known. */
+        int32_t jump(DxOpcode opcode, int32_t target);
+
+        /** Points the jump-like instruction at `instruction` to `target`. */
+        void patch(int32_t instruction, int32_t target);
+
+        /** `flagOffsets` holds the value and name expression of each flag, one after the other. */
+        void scene(const DxStrRef& name, int32_t codeOffset, DxVec<int32_t> flagOffsets = {});
+
+        void function(const DxStrRef& name, int32_t codeOffset, DxVec<int32_t> flagOffsets = {});
+
+        void definition(const DxStrRef& name, const DxStrRef& value, int32_t codeOffset = -1);
+
+        /** With `nameIndex`, the binary has perfect hash tables for its names, like the compiler writes. */
+        [[nodiscard]] DxVec<std::byte> build(DxbCompression compression, bool nameIndex = true) const;
+
+        void save(const DxStrRef& filename, DxbCompression compression, bool nameIndex = true) const;
+
+        /**
+         * Writes a translation file for the binary, with `prefix` put before every translated string, in translation
+         * format version 0 or, if `indexed`, 1.
+         */
+        void saveTranslation(const DxStrRef& filename, const DxStrRef& prefix, bool indexed) const;
+    };
+}
+
+#endif //LIBDIANNEX_BENCH_DXBGENERATOR_HPP
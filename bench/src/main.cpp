@@ -0,0 +1,583 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include <diannex/DxInterpreter.hpp>
+
+#include "DxbGenerator.hpp"
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <tuple>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace diannex;
+using namespace diannex::bench;
+
+namespace
+{
+    DxStrRef g_filter{};
+
+    /**
+     * Runs `func` repeatedly for at least `minTime` after a short warmup, then prints the mean time per iteration.
+     * Skipped if a filter was given on the command line that isn't part of `name`.
+     */
+    template<class Func>
+    void bench(const DxStrRef& name, Func&& func, std::chrono::milliseconds minTime = std::chrono::milliseconds(250))
+    {
+        using Clock = std::chrono::steady_clock;
+
+        if (!g_filter.empty() && name.find(g_filter) == DxStrRef::npos)
+            return;
+
+        for (int i = 0; i < 3; ++i)
+            func();
+
+        size_t iterations = 0;
+        auto start = Clock::now();
+        auto elapsed = Clock::duration{};
+        do
+        {
+            func();
+            iterations++;
+            elapsed = Clock::now() - start;
+        }
+        while (elapsed < minTime);
+
+        auto ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (double)iterations;
+        std::cout << DxFormat("{:<48} {:>14.1f} ns/iter {:>10} iters\n", name, ns, iterations);
+    }
+
+    /**
+     * Keeps the optimizer from discarding a result that is otherwise unused.
+     */
+    template<class T>
+    void keep(T&& value)
+    {
+        #ifdef _MSC_VER
+        // MSVC has no inline assembly on x64, so publish the address through a volatile store instead
+        static const void* volatile sink;
+        sink = &value;
+        _ReadWriteBarrier();
+        #else
+        asm volatile("" : : "r,m"(value) : "memory");
+        #endif
+    }
+
+    DxInterpreter make_sample_interpreter()
+    {
+        DxInterpreter interpreter(DxData::fromFile("data/sample.dxb"));
+        interpreter.textHandler([](auto)
+                                {});
+        interpreter.choiceHandler([](auto)
+                                  {});
+        interpreter.weightedChanceHandler([](const auto&)
+                                          { return 0; });
+        interpreter.registerFunction("getFlag", [](const std::string&)
+        { return DxValue{}; });
+        interpreter.registerFunction("setFlag", [](const std::string&, const DxValue&)
+        {});
+        interpreter.registerFunction("awardPoints", [](int)
+        {});
+        interpreter.registerFunction("deductPoints", [](bool, int)
+        {});
+        interpreter.registerFunction("getPlayerName", []
+        { return "Player"s; });
+        return interpreter;
+    }
+
+    void run_to_end(DxInterpreter& interpreter, const DxStrRef& scene)
+    {
+        interpreter.runScene(scene);
+        while (interpreter.state() != DxInterpreter::State::Inactive)
+        {
+            if (interpreter.state() == DxInterpreter::State::InChoice)
+                interpreter.selectChoice(0);
+            else
+                interpreter.resumeScene();
+        }
+    }
+
+    #pragma region Generated scenes
+
+    constexpr int TextLines = 1'000;
+    constexpr int LoopIterations = 100'000;
+    constexpr int NativeCalls = 10'000;
+    constexpr int Choices = 1'000;
+    constexpr int MenuDefinitions = 100;
+    constexpr int FlaggedScenes = 2'000;
+    constexpr int FlagsPerScene = 4;
+
+    /**
+     * Emits `local0 = 0; while (local0 < count) { body; local0 += 1; }`.
+     */
+    template<class Body>
+    void emit_counted_loop(DxbGenerator& gen, int count, Body&& body)
+    {
+        gen.emit(DxOpcode::pushi, 0);
+        gen.emit(DxOpcode::setvarloc, 0);
+
+        auto loop = gen.offset();
+        gen.emit(DxOpcode::pushvarloc, 0);
+        gen.emit(DxOpcode::pushi, count);
+        gen.emit(DxOpcode::cmplt);
+        auto exit = gen.emit(DxOpcode::jf, 0);
+
+        body();
+
+        gen.emit(DxOpcode::pushvarloc, 0);
+        gen.emit(DxOpcode::pushi, 1);
+        gen.emit(DxOpcode::add);
+        gen.emit(DxOpcode::setvarloc, 0);
+        gen.jump(DxOpcode::j, loop);
+
+        gen.patch(exit, gen.offset());
+    }
+
+    void emit_text_scene(DxbGenerator& gen, const DxStrRef& name, int lines, int firstLine = 0)
+    {
+        gen.scene(name, gen.offset());
+        for (int i = 0; i < lines; ++i)
+        {
+            auto text = gen.translation(DxFormat("Line {} of a generated scene, long enough to be typical.",
+                                                 firstLine + i));
+            gen.emit(DxOpcode::pushs, (int32_t)text);
+            gen.emit(DxOpcode::textrun);
+        }
+        gen.emit(DxOpcode::exit);
+    }
+
+    /**
+     * One file with a scene per interpreter workload: lots of text, a tight arithmetic loop, a loop calling into a
+     * registered function, and a loop presenting a two-way choice.
+     */
+    DxbGenerator make_workload_binary()
+    {
+        DxbGenerator gen;
+
+        emit_text_scene(gen, "bench.text", TextLines);
+
+        gen.scene("bench.loop", gen.offset());
+        emit_counted_loop(gen, LoopIterations, []
+        {});
+        gen.emit(DxOpcode::exit);
+
+        gen.scene("bench.callext", gen.offset());
+        auto native = (int32_t)gen.string("bench.native");
+        emit_counted_loop(gen, NativeCalls, [&]
+        {
+            gen.emit(DxOpcode::pushvarloc, 0);
+            gen.emit(DxOpcode::callext, native, 1);
+            gen.emit(DxOpcode::pop);
+        });
+        gen.emit(DxOpcode::exit);
+
+        gen.scene("bench.choice", gen.offset());
+        auto yes = (int32_t)gen.translation("Yes");
+        auto no = (int32_t)gen.translation("No");
+        emit_counted_loop(gen, Choices, [&]
+        {
+            gen.emit(DxOpcode::choicebeg);
+            DxVec<int32_t> options;
+            for (auto text: { yes, no })
+            {
+                gen.emit(DxOpcode::pushs, text);
+                gen.emit(DxOpcode::pushd, 1.0);
+                options.push_back(gen.emit(DxOpcode::choiceadd, 0));
+            }
+            gen.emit(DxOpcode::choicesel);
+            for (auto option: options)
+                gen.patch(option, gen.offset());
+        });
+        gen.emit(DxOpcode::exit);
+
+        // A UI's worth of definitions, every fourth one interpolated
+        auto player = (int32_t)gen.string("Player");
+        for (int i = 0; i < MenuDefinitions; ++i)
+        {
+            if (i % 4 == 0)
+            {
+                auto code = gen.emit(DxOpcode::pushbs, player);
+                gen.emit(DxOpcode::exit);
+                gen.definition(DxFormat("menu.item{}", i), DxFormat("Item {} for ${{0}}", i), code);
+            }
+            else
+            {
+                gen.definition(DxFormat("menu.item{}", i), DxFormat("Item {}", i));
+            }
+        }
+
+        return gen;
+    }
+
+    /**
+     * Text scenes of 16 lines each until the binary is about `targetSize` bytes, for measuring load times.
+     */
+    DxbGenerator make_bulk_binary(size_t targetSize)
+    {
+        DxbGenerator gen;
+        // Roughly: 10 bytes of code, 60 of text and a bit of scene metadata per line
+        constexpr size_t BytesPerScene = 16 * 70 + 16;
+        auto sceneCount = std::max<size_t>(1, targetSize / BytesPerScene);
+        for (size_t i = 0; i < sceneCount; ++i)
+            emit_text_scene(gen, DxFormat("bulk.scene{}", i), 16, (int)(i * 16));
+        return gen;
+    }
+
+    /**
+     * Scenes that each declare a few flags with a computed default and name, as startup cost depends on their count.
+     */
+    DxbGenerator make_flagged_binary()
+    {
+        DxbGenerator gen;
+        for (int i = 0; i < FlaggedScenes; ++i)
+        {
+            DxVec<int32_t> flagOffsets;
+            for (int j = 0; j < FlagsPerScene; ++j)
+            {
+                flagOffsets.push_back(gen.emit(DxOpcode::pushi, j));
+                gen.emit(DxOpcode::pushi, 1);
+                gen.emit(DxOpcode::add);
+                gen.emit(DxOpcode::exit);
+
+                flagOffsets.push_back(gen.emit(DxOpcode::pushbs, (int32_t)gen.string(DxFormat("scene{}.", i))));
+                gen.emit(DxOpcode::pushi, j);
+                gen.emit(DxOpcode::add);
+                gen.emit(DxOpcode::exit);
+            }
+
+            auto code = gen.offset();
+            gen.emit(DxOpcode::freeloc, 0);
+            gen.emit(DxOpcode::exit);
+            gen.scene(DxFormat("flagged.scene{}", i), code, std::move(flagOffsets));
+        }
+        return gen;
+    }
+
+    /**
+     * As many scenes, functions and definitions as a large game has, all with the same code, for measuring name
+     * lookups.
+     */
+    DxbGenerator make_symbol_binary(int count)
+    {
+        DxbGenerator gen;
+        auto code = gen.emit(DxOpcode::exit);
+        for (int i = 0; i < count; ++i)
+        {
+            gen.scene(DxFormat("symbols.scene{}", i), code);
+            gen.function(DxFormat("symbols.function{}", i), code);
+            gen.definition(DxFormat("symbols.definition{}", i), "Value");
+        }
+        return gen;
+    }
+
+    #pragma endregion
+
+    void bench_loading(const std::filesystem::path& dir)
+    {
+        constexpr std::pair<DxStrRef, size_t> sizes[] = {
+            { "small", 16 * 1024 },
+            { "medium", 1024 * 1024 },
+            { "huge", 32 * 1024 * 1024 }
+        };
+
+        for (const auto& [label, size]: sizes)
+        {
+            auto gen = make_bulk_binary(size);
+            constexpr std::tuple<DxbCompression, DxStrRef, DxStrRef> compressions[] = {
+                { DxbCompression::None, "", "" },
+                { DxbCompression::Zlib, "_z", ", zlib" },
+                { DxbCompression::Lz, "_lz", ", lz" }
+            };
+            for (const auto& [compression, suffix, name]: compressions)
+            {
+                auto path = (dir / DxFormat("{}{}.dxb", label, suffix)).string();
+                gen.save(path, compression);
+
+                auto fileSize = (double)std::filesystem::file_size(path) / 1024.0;
+                bench(DxFormat("load/{} ({:.0f} KiB{})", label, fileSize, name), [&]
+                { keep(DxData::fromFile(path)); });
+                bench(DxFormat("load/{} ({:.0f} KiB{}, mapped)", label, fileSize, name), [&]
+                { keep(DxData::fromFile(path, DxData::LoadMode::Map)); });
+            }
+
+            // Decoded into shared memory once, then attached to like every other process would
+            auto segment = DxFormat("/libdnxpp-bench-{}", label);
+            DxData::removeSharedImage(segment);
+            auto published = DxData::publishSharedImage((dir / DxFormat("{}_lz.dxb", label)).string(), segment);
+            bench(DxFormat("load/{} (shared image)", label), [&]
+            { keep(DxData::fromSharedImage(segment)); });
+            DxData::removeSharedImage(segment);
+        }
+    }
+
+    void bench_translations(const std::filesystem::path& dir)
+    {
+        // Switching the language of the huge binary from the loading benchmarks
+        auto gen = make_bulk_binary(32 * 1024 * 1024);
+        auto data = DxData::fromFile((dir / "huge.dxb").string(), DxData::LoadMode::Map);
+        for (bool indexed: { false, true })
+        {
+            auto path = (dir / DxFormat("huge{}.dxt", indexed ? "_indexed" : "")).string();
+            gen.saveTranslation(path, "Translated: ", indexed);
+
+            auto fileSize = (double)std::filesystem::file_size(path) / 1024.0;
+            auto label = DxFormat("{:.0f} KiB{}", fileSize, indexed ? ", indexed" : "");
+            bench(DxFormat("translation/huge ({})", label), [&]
+            { data.loadTranslationFile(path); });
+            bench(DxFormat("translation/huge ({}, mapped)", label), [&]
+            { data.loadTranslationFile(path, DxData::LoadMode::Map); });
+        }
+    }
+
+    void bench_scenes(const std::filesystem::path& dir)
+    {
+        auto path = (dir / "workload.dxb").string();
+        make_workload_binary().save(path, DxbCompression::None);
+
+        DxInterpreter interpreter(DxData::fromFile(path));
+        interpreter.textHandler([](auto)
+                                {});
+        interpreter.choiceHandler([](auto)
+                                  {});
+        interpreter.registerFunction("bench.native", [](int value)
+        { return value + 1; });
+
+        bench(DxFormat("scene/text ({} lines)", TextLines), [&]
+        { run_to_end(interpreter, "bench.text"); });
+        bench(DxFormat("scene/loop ({} iterations)", LoopIterations), [&]
+        { run_to_end(interpreter, "bench.loop"); });
+        bench(DxFormat("scene/callext ({} calls)", NativeCalls), [&]
+        { run_to_end(interpreter, "bench.callext"); });
+        bench(DxFormat("scene/choice ({} choices)", Choices), [&]
+        { run_to_end(interpreter, "bench.choice"); });
+
+        // Forks start out with no evaluated definitions, so these measure a cold lookup
+        DxVec<DxStr> menuNames;
+        for (int i = 0; i < MenuDefinitions; ++i)
+            menuNames.push_back(DxFormat("menu.item{}", i));
+        bench(DxFormat("definitions/one by one ({})", MenuDefinitions), [&]
+        {
+            auto fork = interpreter.fork();
+            for (const auto& name: menuNames)
+                keep(fork.definition(name));
+        });
+        bench(DxFormat("definitions/prefix ({})", MenuDefinitions), [&]
+        {
+            auto fork = interpreter.fork();
+            keep(fork.definitions("menu."));
+        });
+        bench(DxFormat("definitions/prefix ({}, cached)", MenuDefinitions), [&]
+        { keep(interpreter.definitions("menu.")); });
+        bench("definitions/by name (cached)", [&]
+        { keep(interpreter.definition("menu.item42")); });
+        auto item42 = interpreter.definitionId("menu.item42");
+        bench("definitions/by id (cached)", [&]
+        { keep(interpreter.definition(item42)); });
+
+        auto sample = make_sample_interpreter();
+        bench("scene/sample", [&]
+        { run_to_end(sample, "area0.intro"); });
+
+        // One arena per scene run, released by the end scene handler
+        std::array<std::byte, 64 * 1024> buffer{};
+        std::pmr::monotonic_buffer_resource arena{ buffer.data(), buffer.size() };
+        sample.memoryResource(&arena);
+        sample.endSceneHandler([&arena](auto)
+                               { arena.release(); });
+        bench("scene/sample (monotonic resource)", [&]
+        { run_to_end(sample, "area0.intro"); });
+        sample.endSceneHandler([](auto)
+                               {});
+        sample.memoryResource(nullptr);
+
+        #ifdef DIANNEX_PROFILER
+        // Overhead of the profiler while it is switched on, compared to the line above
+        sample.profiler().enable();
+        bench("scene/sample (profiler enabled)", [&]
+        { run_to_end(sample, "area0.intro"); });
+        sample.profiler().enable(false);
+        #endif
+    }
+
+    void bench_paging(const std::filesystem::path& dir)
+    {
+        // Every 7th scene of the huge binary from the loading benchmarks, so that few of them share pages
+        auto path = (dir / "huge.dxb").string();
+        for (size_t budget: { (size_t)0, (size_t)1024 * 1024 })
+        {
+            auto data = DxData::fromFile(path, DxData::LoadMode::Map);
+            if (budget != 0)
+                data.residencyBudget(budget);
+
+            DxVec<DxSceneId> scenes;
+            for (uint32_t i = 0; i < data.sceneTable().size(); i += 7)
+                scenes.push_back((DxSceneId)i);
+
+            DxInterpreter interpreter(std::move(data));
+            interpreter.textHandler([](auto)
+                                    {});
+
+            size_t next = 0;
+            bench(DxFormat("scene/bulk, mapped ({})", budget != 0 ? "1 MiB resident" : "all resident"), [&]
+            {
+                interpreter.runScene(scenes[next++ % scenes.size()]);
+                while (interpreter.state() != DxInterpreter::State::Inactive)
+                    interpreter.resumeScene();
+            });
+        }
+    }
+
+    void bench_flags(const std::filesystem::path& dir)
+    {
+        auto path = (dir / "flagged.dxb").string();
+        make_flagged_binary().save(path, DxbCompression::None);
+
+        // Loading to running the first scene, with flags set up front or only for the scene that runs
+        for (bool eager: { true, false })
+        {
+            bench(DxFormat("flags/first scene ({} scenes, {})", FlaggedScenes, eager ? "initializeFlags" : "lazy"), [&]
+            {
+                DxMap<DxStr, DxValue> flags;
+                DxInterpreter interpreter(DxData::fromFile(path));
+                interpreter.flagSetHandler([&](const DxStrRef& name, DxValue value)
+                                           { flags[DxStr{ name }] = std::move(value); });
+                interpreter.flagGetHandler([&](const DxStrRef& name)
+                                           {
+                                               auto it = flags.find(DxStr{ name });
+                                               return it != flags.end() ? it->second : DxValue{};
+                                           });
+                if (eager)
+                    interpreter.initializeFlags();
+                run_to_end(interpreter, "flagged.scene0");
+                keep(flags.size());
+            });
+        }
+    }
+
+    void bench_names(const std::filesystem::path& dir)
+    {
+        constexpr int Symbols = 20000;
+        constexpr int Lookups = 1000;
+        auto gen = make_symbol_binary(Symbols);
+
+        DxVec<DxStr> scenes, functions, definitions;
+        for (int i = 0; i < Lookups; ++i)
+        {
+            auto symbol = i * (Symbols / Lookups);
+            scenes.push_back(DxFormat("symbols.scene{}", symbol));
+            functions.push_back(DxFormat("symbols.function{}", symbol));
+            definitions.push_back(DxFormat("symbols.definition{}", symbol));
+        }
+
+        for (bool nameIndex: { false, true })
+        {
+            auto path = (dir / DxFormat("symbols{}.dxb", nameIndex ? "_indexed" : "")).string();
+            gen.save(path, DxbCompression::None, nameIndex);
+            auto label = DxFormat("{} symbols{}", Symbols, nameIndex ? ", name index" : "");
+
+            bench(DxFormat("names/load ({}, mapped)", label), [&]
+            { keep(DxData::fromFile(path, DxData::LoadMode::Map)); });
+
+            auto data = DxData::fromFile(path, DxData::LoadMode::Map);
+            bench(DxFormat("names/{} scenes ({})", Lookups, label), [&]
+            {
+                for (const auto& name: scenes)
+                    keep(data.findScene(name));
+            });
+            bench(DxFormat("names/{} functions ({})", Lookups, label), [&]
+            {
+                for (const auto& name: functions)
+                    keep(data.findFunction(name));
+            });
+            bench(DxFormat("names/{} definitions ({})", Lookups, label), [&]
+            {
+                for (const auto& name: definitions)
+                    keep(data.findDefinition(name));
+            });
+        }
+    }
+
+    void bench_interpolate()
+    {
+        DxVec<DxStr> elems{ "Player", "42", "the castle" };
+
+        bench("interpolate/none", []
+        { keep(DxInterpreter::interpolate("Nothing to replace in this line of text at all.", {})); });
+        bench("interpolate/three", [&]
+        { keep(DxInterpreter::interpolate("Hello ${0}, you have ${1} points. Welcome to ${2}!", elems)); });
+        bench("interpolate/escaped", [&]
+        { keep(DxInterpreter::interpolate(R"(Costs \$5, or ${1} \${0} for ${0}.)", elems)); });
+    }
+
+    void bench_values()
+    {
+        DxValue i1{ 40, DxValueType::Integer };
+        DxValue i2{ 2, DxValueType::Integer };
+        DxValue d1{ 1.5, DxValueType::Double };
+        DxValue s1{ "Hello, "s, DxValueType::String };
+        DxValue s2{ "world"s, DxValueType::String };
+
+        bench("value/add int", [&]
+        { keep(i1 + i2); });
+        bench("value/mul int*double", [&]
+        { keep(i1 * d1); });
+        bench("value/add string", [&]
+        { keep(s1 + s2); });
+        bench("value/cmplt int", [&]
+        { keep(i1 < i2); });
+        bench("value/convert int->string", [&]
+        { keep(i1.convert(DxValueType::String)); });
+        bench("value/convert string->double", [&]
+        { keep(DxValue{ "3.25"s, DxValueType::String }.convert(DxValueType::Double)); });
+        bench("value/coerce int round trip", [&]
+        { keep(coerce_from_value<int>(coerce_to_value(42))); });
+        bench("value/copy string", [&]
+        { keep(DxValue{ s1 }); });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        g_filter = argv[1];
+
+    try
+    {
+        auto dir = std::filesystem::path("bench_data");
+        std::filesystem::create_directories(dir);
+
+        bench_loading(dir);
+        bench_paging(dir);
+        bench_translations(dir);
+        bench_scenes(dir);
+        bench_flags(dir);
+        bench_names(dir);
+        bench_interpolate();
+        bench_values();
+    }
+    catch (const diannex_exception& ex)
+    {
+        std::cerr << "[Diannex::Bench]: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
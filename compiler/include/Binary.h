@@ -5,15 +5,29 @@
 #include "Context.h"
 #include "BinaryWriter.h"
 
-#define DIANNEX_BINARY_VERSION 4
-#define DIANNEX_BINARY_TRANSLATION_VERSION 0
+#define DIANNEX_BINARY_VERSION 5
+#define DIANNEX_BINARY_TRANSLATION_VERSION 1
 
 namespace diannex
 {
+    // Types of the sections in the section directory of a binary (format version 5 and up)
+    enum class SectionType : uint32_t
+    {
+        Scenes = 1,
+        Functions = 2,
+        Definitions = 3,
+        Bytecode = 4,
+        Strings = 5,
+        Translations = 6,
+        ExternalFunctions = 7,
+        TranslationIndex = 8,
+        NameIndex = 9
+    };
+
     class Binary
     {
     public:
-        static uint32_t Compress(const char* srcBuff, uint32_t srcSize, std::vector<uint8_t>& out);
+        static uint32_t Compress(const char* srcBuff, uint32_t srcSize, std::vector<uint8_t>& out, bool fast = false);
         static bool Write(BinaryWriter* bw, CompileContext* ctx);
         static bool WriteTranslationText(BinaryWriter* bw, const std::vector<std::string>& text);
     private:
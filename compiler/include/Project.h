@@ -44,6 +44,9 @@ namespace diannex
         // Whether or not to compress the binary using zlib. default: true
         bool compression;
 
+        // Whether to compress with the fast LZ codec instead of zlib, when compressing. default: false
+        bool compressionFast;
+
         // Predefined macros/defines to be used in source files. default: None
         std::unordered_map<std::string, std::string> macros;
 
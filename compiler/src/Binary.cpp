@@ -1,14 +1,250 @@
 #include "Binary.h"
 
 #include <algorithm>
+#include <cstring>
 #include <random>
 #include <libs/miniz/miniz.h>
 #include <set>
 
 namespace diannex
 {
-    uint32_t Binary::Compress(const char* srcBuff, uint32_t srcSize, std::vector<uint8_t>& out)
+    // Fast LZ format, read by the runtime's lz_decompress (see utils/DxLz.hpp there for the layout)
+    static const uint32_t lzFrameSize = 256 * 1024;
+    static const uint32_t lzMinMatch = 4;
+    static const uint32_t lzMaxDistance = 65535;
+    static const int lzHashBits = 16;
+
+    // Minimal perfect hash tables of names, read in place by the runtime's DxNameIndex (see DxNameIndex.hpp there for
+    // the layout); these have to stay the same as DxNameIndex::hash, DxNameIndex::bucket and DxNameIndex::slot
+    static uint64_t nameMix(uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDu;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53u;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static uint32_t nameReduce(uint32_t value, uint32_t size)
+    {
+        return (uint32_t)(((uint64_t)value * size) >> 32);
+    }
+
+    static uint64_t nameHash(const std::string& name)
+    {
+        uint64_t hash = name.size();
+        for (size_t i = 0; i < name.size(); i += 8)
+        {
+            uint64_t block = 0;
+            for (size_t j = 0; j < 8 && i + j < name.size(); j++)
+                block |= (uint64_t)(uint8_t)name[i + j] << (8 * j);
+            hash ^= block * 0x87C37B91114253D5u;
+            hash = ((hash << 27) | (hash >> 37)) * 0x4CF5AD432745937Fu;
+        }
+        return nameMix(hash);
+    }
+
+    static uint32_t nameBucket(uint64_t hash, uint32_t size)
+    {
+        return nameReduce((uint32_t)hash, size);
+    }
+
+    static uint32_t nameSlot(uint64_t hash, uint32_t seed, uint32_t size)
+    {
+        return nameReduce((uint32_t)(nameMix(hash ^ (seed * 0x9E3779B97F4A7C15u)) >> 32), size);
+    }
+
+    static bool nameHashesUnique(const std::vector<const std::string*>& names)
+    {
+        std::vector<uint64_t> hashes;
+        hashes.reserve(names.size());
+        for (const std::string* name : names)
+            hashes.push_back(nameHash(*name));
+        std::sort(hashes.begin(), hashes.end());
+        return std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end();
+    }
+
+    // Expects names whose hashes are all different, as no seed can separate two names with the same hash
+    static void writeNameIndex(BinaryMemoryWriter& bmw, const std::vector<const std::string*>& names)
+    {
+        uint32_t count = names.size();
+        std::vector<uint64_t> hashes(count);
+        for (uint32_t i = 0; i < count; i++)
+            hashes[i] = nameHash(*names[i]);
+
+        std::vector<std::vector<uint32_t>> buckets(count);
+        for (uint32_t i = 0; i < count; i++)
+            buckets[nameBucket(hashes[i], count)].push_back(i);
+
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b)
+        {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        // Biggest buckets first, each with the first seed that puts all of its names in free slots
+        std::vector<int32_t> seeds(count, 0);
+        std::vector<uint32_t> indices(count, 0);
+        std::vector<bool> taken(count, false);
+        std::vector<uint32_t> slots;
+        uint32_t next = 0;
+        for (uint32_t bucket : order)
+        {
+            const auto& members = buckets[bucket];
+            if (members.size() > 1)
+            {
+                for (uint32_t seed = 1;; seed++)
+                {
+                    slots.clear();
+                    for (uint32_t member : members)
+                    {
+                        uint32_t slot = nameSlot(hashes[member], seed, count);
+                        if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                            break;
+                        slots.push_back(slot);
+                    }
+                    if (slots.size() != members.size())
+                        continue;
+
+                    seeds[bucket] = (int32_t)seed;
+                    for (size_t i = 0; i < members.size(); i++)
+                    {
+                        taken[slots[i]] = true;
+                        indices[slots[i]] = members[i];
+                    }
+                    break;
+                }
+            }
+            else if (members.size() == 1)
+            {
+                // Buckets of one name go straight into whichever slot is left
+                while (taken[next])
+                    next++;
+                taken[next] = true;
+                seeds[bucket] = -(int32_t)next - 1;
+                indices[next] = members[0];
+            }
+        }
+
+        bmw.WriteUInt32(count);
+        for (int32_t seed : seeds)
+            bmw.WriteInt32(seed);
+        for (uint32_t index : indices)
+            bmw.WriteUInt32(index);
+    }
+
+    static uint32_t lzLoad32(const uint8_t* ptr)
+    {
+        uint32_t value;
+        memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+
+    static uint32_t lzHash(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - lzHashBits);
+    }
+
+    static void lzWriteLength(std::vector<uint8_t>& out, uint32_t length)
+    {
+        for (; length >= 255; length -= 255)
+            out.push_back(255);
+        out.push_back((uint8_t)length);
+    }
+
+    static void lzWriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, uint32_t literalLength,
+                                uint32_t distance, uint32_t matchLength)
+    {
+        uint32_t matchCode = matchLength - lzMinMatch;
+        out.push_back((uint8_t)((std::min<uint32_t>(literalLength, 15) << 4) | std::min<uint32_t>(matchCode, 15)));
+        if (literalLength >= 15)
+            lzWriteLength(out, literalLength - 15);
+        out.insert(out.end(), literals, literals + literalLength);
+        if (matchLength == 0)
+            return;
+
+        out.push_back((uint8_t)(distance & 0xFF));
+        out.push_back((uint8_t)(distance >> 8));
+        if (matchCode >= 15)
+            lzWriteLength(out, matchCode - 15);
+    }
+
+    static void lzCompressFrame(const uint8_t* base, uint32_t size, std::vector<uint8_t>& out,
+                                std::vector<uint32_t>& table)
+    {
+        std::fill(table.begin(), table.end(), 0);
+
+        uint32_t anchor = 0, pos = 0;
+        while (pos + lzMinMatch <= size)
+        {
+            uint32_t sequence = lzLoad32(base + pos);
+            uint32_t& slot = table[lzHash(sequence)];
+            uint32_t candidate = slot;
+            slot = pos;
+            if (candidate >= pos || pos - candidate > lzMaxDistance || lzLoad32(base + candidate) != sequence)
+            {
+                pos++;
+                continue;
+            }
+
+            uint32_t length = lzMinMatch;
+            while (pos + length < size && base[candidate + length] == base[pos + length])
+                length++;
+            while (pos > anchor && candidate > 0 && base[pos - 1] == base[candidate - 1])
+            {
+                pos--;
+                candidate--;
+                length++;
+            }
+
+            lzWriteSequence(out, base + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+            if (pos + lzMinMatch <= size)
+                table[lzHash(lzLoad32(base + pos - 2))] = pos - 2;
+        }
+
+        // Only literals are left, ending the frame
+        lzWriteSequence(out, base + anchor, size - anchor, 0, 0);
+    }
+
+    static uint32_t lzCompress(const char* srcBuff, uint32_t srcSize, std::vector<uint8_t>& out)
+    {
+        const uint8_t* src = (const uint8_t*)srcBuff;
+        std::vector<uint32_t> table(1 << lzHashBits);
+        out.clear();
+        out.reserve(srcSize / 2);
+
+        for (uint32_t offset = 0; offset < srcSize; offset += lzFrameSize)
+        {
+            uint32_t frameSize = std::min(lzFrameSize, srcSize - offset);
+            size_t header = out.size();
+            out.resize(header + 4);
+            lzCompressFrame(src + offset, frameSize, out, table);
+
+            uint32_t size = (uint32_t)(out.size() - header - 4);
+            if (size >= frameSize)
+            {
+                // Stored as is, with the top bit of its size set
+                out.resize(header + 4);
+                out.insert(out.end(), src + offset, src + offset + frameSize);
+                size = frameSize | (1u << 31);
+            }
+            for (int i = 0; i < 4; i++)
+                out[header + i] = (uint8_t)(size >> (i * 8));
+        }
+
+        return (uint32_t)out.size();
+    }
+
+    uint32_t Binary::Compress(const char* srcBuff, uint32_t srcSize, std::vector<uint8_t>& out, bool fast)
     {
+        if (fast)
+            return lzCompress(srcBuff, srcSize, out);
+
         uLong outSize = compressBound(srcSize);
         out.resize(outSize);
         if (compress(&out[0], &outSize, (const unsigned char*)srcBuff, srcSize) != Z_OK)
@@ -30,13 +266,23 @@ namespace diannex
 
         // Flags
         bool compressed = ctx->project->options.compression,
+             fast = compressed && ctx->project->options.compressionFast,
              internalTranslationFile = !ctx->project->options.translationPublic;
-        bw->WriteUInt8((uint8_t)compressed | ((uint8_t)internalTranslationFile << 1));
+        bw->WriteUInt8((uint8_t)(compressed && !fast) | ((uint8_t)internalTranslationFile << 1) |
+                       ((uint8_t)internalTranslationFile << 2) | // Translation index
+                       ((uint8_t)fast << 3));
 
+        // Blocks are written one after the other, each with its size in front of it, and then laid out as sections
         BinaryMemoryWriter bmw;
+        std::vector<std::pair<SectionType, uint32_t>> sections;
+        auto section = [&](SectionType type)
+        {
+            sections.emplace_back(type, bmw.GetSize());
+            return bmw.GetSize();
+        };
 
         // Scene metadata
-        uint32_t begin = bmw.GetSize();
+        uint32_t begin = section(SectionType::Scenes);
         bmw.WriteUInt32(0);
         bmw.WriteUInt32(ctx->sceneBytecode.size());
         for (auto it = ctx->sceneBytecode.begin(); it != ctx->sceneBytecode.end(); ++it)
@@ -53,7 +299,7 @@ namespace diannex
         bmw.SizePatch(begin);
 
         // Function metadata
-        begin = bmw.GetSize();
+        begin = section(SectionType::Functions);
         bmw.WriteUInt32(0);
         bmw.WriteUInt32(ctx->functionBytecode.size());
         for (auto it = ctx->functionBytecode.begin(); it != ctx->functionBytecode.end(); ++it)
@@ -69,11 +315,19 @@ namespace diannex
         }
         bmw.SizePatch(begin);
 
-        // Definition metadata
-        begin = bmw.GetSize();
+        // Definition metadata, sorted by name so the runtime can use it as is
+        std::vector<decltype(ctx->definitionBytecode)::const_iterator> definitions;
+        for (auto it = ctx->definitionBytecode.cbegin(); it != ctx->definitionBytecode.cend(); ++it)
+            definitions.push_back(it);
+        std::sort(definitions.begin(), definitions.end(), [](const auto& a, const auto& b)
+        {
+            return a->first < b->first;
+        });
+
+        begin = section(SectionType::Definitions);
         bmw.WriteUInt32(0);
-        bmw.WriteUInt32(ctx->definitionBytecode.size());
-        for (auto it = ctx->definitionBytecode.begin(); it != ctx->definitionBytecode.end(); ++it)
+        bmw.WriteUInt32(definitions.size());
+        for (const auto& it : definitions)
         {
             // Symbol
             bmw.WriteUInt32(ctx->string(it->first));
@@ -95,6 +349,7 @@ namespace diannex
         int externalFunctionIndex = 0;
 
         // Bytecode
+        section(SectionType::Bytecode);
         bmw.WriteUInt32(ctx->offset);
         for (auto it = ctx->bytecode.begin(); it != ctx->bytecode.end(); ++it)
         {
@@ -147,7 +402,7 @@ namespace diannex
         }
 
         // Internal string table
-        begin = bmw.GetSize();
+        begin = section(SectionType::Strings);
         bmw.WriteUInt32(0);
         bmw.WriteUInt32(ctx->internalStrings.size());
         for (auto it = ctx->internalStrings.begin(); it != ctx->internalStrings.end(); ++it)
@@ -164,7 +419,7 @@ namespace diannex
                     count++;
             }
 
-            begin = bmw.GetSize();
+            begin = section(SectionType::Translations);
             bmw.WriteUInt32(0);
             bmw.WriteUInt32(count);
             for (auto it = ctx->translationInfo.begin(); it != ctx->translationInfo.end(); ++it)
@@ -176,18 +431,96 @@ namespace diannex
         }
 
         // External function list
-        begin = bmw.GetSize();
+        begin = section(SectionType::ExternalFunctions);
         bmw.WriteUInt32(0);
         bmw.WriteUInt32(externalFunctions.size());
         for (auto it = externalFunctions.begin(); it != externalFunctions.end(); ++it)
             bmw.WriteUInt32(*it);
         bmw.SizePatch(begin);
 
-        uint32_t size = bmw.GetSize();
+        // Translation index (if applicable), where each translated string ends, so the runtime doesn't need to scan
+        if (internalTranslationFile)
+        {
+            begin = section(SectionType::TranslationIndex);
+            bmw.WriteUInt32(0);
+            uint32_t count = 0;
+            for (auto it = ctx->translationInfo.begin(); it != ctx->translationInfo.end(); ++it)
+            {
+                if (!it->isComment)
+                    count++;
+            }
+            bmw.WriteUInt32(count);
+            uint32_t end = 0;
+            for (auto it = ctx->translationInfo.begin(); it != ctx->translationInfo.end(); ++it)
+            {
+                if (!it->isComment)
+                {
+                    // Same as WriteString, which only adds a terminator if there isn't one already
+                    const auto& text = it->text;
+                    end += text.size() + (text.empty() || text.back() != '\0' ? 1 : 0);
+                    bmw.WriteUInt32(end);
+                }
+            }
+            bmw.SizePatch(begin);
+        }
+
+        // Name index, a perfect hash table each for scene, function and definition names, so that the runtime doesn't
+        // have to build any at load. Two names sharing a hash can't be told apart by any seed, so the section is left
+        // out then, and the runtime falls back to building its own lookups
+        {
+            std::vector<const std::string*> sceneNames, functionNames, definitionNames;
+            for (auto it = ctx->sceneBytecode.begin(); it != ctx->sceneBytecode.end(); ++it)
+                sceneNames.push_back(&it->first);
+            for (auto it = ctx->functionBytecode.begin(); it != ctx->functionBytecode.end(); ++it)
+                functionNames.push_back(&it->first);
+            for (const auto& it : definitions)
+                definitionNames.push_back(&it->first);
+
+            if (nameHashesUnique(sceneNames) && nameHashesUnique(functionNames) && nameHashesUnique(definitionNames))
+            {
+                begin = section(SectionType::NameIndex);
+                bmw.WriteUInt32(0);
+                writeNameIndex(bmw, sceneNames);
+                writeNameIndex(bmw, functionNames);
+                writeNameIndex(bmw, definitionNames);
+                bmw.SizePatch(begin);
+            }
+        }
+
+        // Section directory (type, offset and size of each section), then the sections without their sizes, each
+        // aligned to 4 bytes so that the runtime can use them in place
+        const uint8_t* blocks = (const uint8_t*)bmw.GetBuffer();
+        std::vector<uint32_t> sizes, offsets;
+        uint32_t offset = 4 + (uint32_t)sections.size() * 12;
+        for (auto& [type, blockBegin] : sections)
+        {
+            const uint8_t* ptr = blocks + blockBegin;
+            sizes.push_back(ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24));
+            offset = (offset + 3) & ~3u;
+            offsets.push_back(offset);
+            offset += sizes.back();
+        }
+
+        BinaryMemoryWriter content;
+        content.WriteUInt32(sections.size());
+        for (size_t i = 0; i < sections.size(); i++)
+        {
+            content.WriteUInt32((uint32_t)sections[i].first);
+            content.WriteUInt32(offsets[i]);
+            content.WriteUInt32(sizes[i]);
+        }
+        for (size_t i = 0; i < sections.size(); i++)
+        {
+            while (content.GetSize() < offsets[i])
+                content.WriteUInt8(0);
+            content.WriteBytes((const char*)blocks + sections[i].second + 4, sizes[i]);
+        }
+
+        uint32_t size = content.GetSize();
         if (compressed)
         {
             std::vector<uint8_t> out;
-            uint32_t compSize = Compress(bmw.GetBuffer(), size, out);
+            uint32_t compSize = Compress(content.GetBuffer(), size, out, fast);
             if (compSize == 0)
                 return false;
             bw->WriteUInt32(size);
@@ -197,7 +530,7 @@ namespace diannex
         else
         {
             bw->WriteUInt32(size);
-            bw->WriteBytes(bmw.GetBuffer(), size);
+            bw->WriteBytes(content.GetBuffer(), size);
         }
 
         return true;
@@ -209,6 +542,17 @@ namespace diannex
         bw->WriteUInt8(DIANNEX_BINARY_TRANSLATION_VERSION);
 
         bw->WriteUInt32((uint32_t)text.size());
+
+        // Index of where each string starts, then where the last one ends, so the runtime can use the file as is
+        uint32_t offset = 0;
+        bw->WriteUInt32(offset);
+        for (auto it = text.begin(); it != text.end(); ++it)
+        {
+            // Same as WriteString, which only adds a terminator if there isn't one already
+            offset += it->size() + (it->empty() || it->back() != '\0' ? 1 : 0);
+            bw->WriteUInt32(offset);
+        }
+
         for (auto it = text.begin(); it != text.end(); ++it)
              bw->WriteString(*it);
 
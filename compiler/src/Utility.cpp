@@ -29,6 +29,7 @@ namespace diannex
                                  {"translation_public", false},
                                  {"translation_public_name", ""},
                                  {"compression", true},
+                                 {"compression_fast", false},
                                  {"macros", nlohmann::json::array()},
                                  {"add_string_ids", false},
                                  {"use_string_ids", false},
@@ -92,6 +93,7 @@ namespace diannex
             proj.options.translationPrivateOutDir = "./translations/";
             proj.options.translationPublic = false;
             proj.options.compression = true;
+            proj.options.compressionFast = false;
             return;
         }
 
@@ -147,6 +149,10 @@ namespace diannex
                                    project["options"]["compression"].get<bool>() :
                                    true;
 
+        proj.options.compressionFast = project["options"].contains("compression_fast") ?
+                                       project["options"]["compression_fast"].get<bool>() :
+                                       false;
+
         proj.options.addStringIds = project["options"].contains("add_string_ids") ?
                                     project["options"]["add_string_ids"].get<bool>() :
                                     false;
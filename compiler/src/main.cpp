@@ -76,6 +76,7 @@ int main(int argc, char** argv)
             ("D,privname", "Name of output private translation file", cxxopts::value<std::string>(), "(default: \"out\")")
             ("d,privdir", "Directory to output private translation files", cxxopts::value<std::string>(), "(default: \"./translations\")")
             ("C,compress", "Whether or not to use compression")
+            ("F,fast", "Compress with the fast LZ codec instead of zlib (implies --compress)")
             ("files", "File(s) to compile", cxxopts::value<std::vector<std::string>>()->default_value(""));
 
 
@@ -391,6 +392,8 @@ int main(int argc, char** argv)
             project.options.translationPrivateOutDir = result["privdir"].as<std::string>();
         if (result["compress"].count())
             project.options.compression = result["compress"].as<bool>();
+        if (result["fast"].count())
+            project.options.compression = project.options.compressionFast = result["fast"].as<bool>();
 
         loaded = true;
     }
@@ -411,7 +414,9 @@ int main(int argc, char** argv)
         project.options.translationPrivate = result["private"].count() == 1 ? result["private"].as<bool>() : false;
         project.options.translationPrivateName = result["privname"].count() == 1 ? result["privname"].as<std::string>() : "out";
         project.options.translationPrivateOutDir = result["privdir"].count() == 1 ? result["privdir"].as<std::string>() : "./translations";
-        project.options.compression = result["compress"].count() == 1 ? result["compress"].as<bool>() : false;
+        project.options.compressionFast = result["fast"].count() == 1 ? result["fast"].as<bool>() : false;
+        project.options.compression = project.options.compressionFast ||
+                                      (result["compress"].count() == 1 ? result["compress"].as<bool>() : false);
         loaded = true;
     }
 
@@ -683,7 +688,7 @@ int main(int argc, char** argv)
         }
         if (!Binary::Write(&bw, &context))
         {
-            std::cout << std::endl << rang::fgB::red << "Failed to compress with zlib!" << rang::fg::reset << std::endl;
+            std::cout << std::endl << rang::fgB::red << "Failed to compress the binary!" << rang::fg::reset << std::endl;
             return 1;
         }
     }
@@ -0,0 +1,203 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include <diannex/DxExplorer.hpp>
+
+#include <chrono>
+#include <iostream>
+
+using namespace diannex;
+
+namespace
+{
+    void usage()
+    {
+        std::cerr << "Usage: dx_explore <binary.dxb> [options]\n"
+                     "  -j, --threads <count>        Worker thread count (default: all cores)\n"
+                     "  --max-instructions <count>   Cut off paths that run longer than this\n"
+                     "  --scene <name>               Only explore this scene (can be repeated)\n"
+                     "  --json                       Write the report as JSON\n";
+    }
+
+    DxStrRef end_name(DxPathEnd end)
+    {
+        constexpr DxStrRef names[] = {
+            "end",
+            "merged",
+            "instruction-limit",
+            "error"
+        };
+        return names[(int)end];
+    }
+
+    DxStr json_escape(const DxStrRef& str)
+    {
+        DxStrBuilder out;
+        for (char c: str)
+        {
+            switch (c)
+            {
+                case '"':
+                    out << "\\\"";
+                    break;
+                case '\\':
+                    out << "\\\\";
+                    break;
+                case '\n':
+                    out << "\\n";
+                    break;
+                default:
+                    if ((unsigned char)c < 0x20)
+                        out << DxFormat("\\u{:04x}", (int)c);
+                    else
+                        out << c;
+            }
+        }
+        return out.str();
+    }
+
+    void write_json(std::ostream& out, const DxExplorerReport& report)
+    {
+        out << "{\n  \"reachableText\": [";
+        for (size_t i = 0; i < report.reachableText.size(); ++i)
+            out << (i ? ", " : "") << report.reachableText[i];
+
+        out << "],\n  \"deadBranches\": [";
+        for (size_t i = 0; i < report.deadBranches.size(); ++i)
+        {
+            const auto& branch = report.deadBranches[i];
+            out << (i ? "," : "") << DxFormat("\n    {{ \"scene\": \"{}\", \"target\": {}, \"kind\": \"{}\" }}",
+                                              json_escape(report.scenes[branch.scene]),
+                                              branch.targetOffset,
+                                              branch.isChoice ? "choice" : "choose");
+        }
+
+        out << "\n  ],\n  \"paths\": [";
+        for (size_t i = 0; i < report.paths.size(); ++i)
+        {
+            const auto& path = report.paths[i];
+            DxStrBuilder decisions;
+            for (size_t j = 0; j < path.decisions.size(); ++j)
+                decisions << (j ? ", " : "") << path.decisions[j];
+
+            out << (i ? "," : "")
+                << DxFormat("\n    {{ \"scene\": \"{}\", \"decisions\": [{}], \"instructions\": {}, \"end\": \"{}\"",
+                            json_escape(report.scenes[path.scene]),
+                            decisions.str(),
+                            path.instructionCount,
+                            end_name(path.end));
+            if (path.end == DxPathEnd::Error)
+                out << DxFormat(", \"error\": \"{}\"", json_escape(path.error));
+            out << " }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void write_text(std::ostream& out, const DxExplorerReport& report)
+    {
+        size_t counts[4]{};
+        for (const auto& path: report.paths)
+            counts[(int)path.end]++;
+
+        out << DxFormat("Explored {} scenes: {} paths ({} ended, {} merged, {} hit the instruction limit, {} errors)\n",
+                        report.scenes.size(), report.paths.size(), counts[0], counts[1], counts[2], counts[3]);
+        out << DxFormat("Reachable text lines: {}\n", report.reachableText.size());
+
+        out << DxFormat("Dead branches: {}\n", report.deadBranches.size());
+        for (const auto& branch: report.deadBranches)
+            out << DxFormat("  {} @ {} ({})\n",
+                            report.scenes[branch.scene],
+                            branch.targetOffset,
+                            branch.isChoice ? "choice" : "choose");
+
+        out << "Paths:\n";
+        for (const auto& path: report.paths)
+        {
+            DxStrBuilder decisions;
+            for (size_t j = 0; j < path.decisions.size(); ++j)
+                decisions << (j ? "," : "") << path.decisions[j];
+            out << DxFormat("  {} [{}] {} instructions ({})", report.scenes[path.scene], decisions.str(),
+                            path.instructionCount, end_name(path.end));
+            if (path.end == DxPathEnd::Error)
+                out << ": " << path.error;
+            out << '\n';
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        usage();
+        return 1;
+    }
+
+    DxStrRef filename = argv[1];
+    DxExplorerOptions options;
+    DxVec<DxStrRef> scenes;
+    bool json = false;
+
+    try
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            DxStrRef arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if ((arg == "-j" || arg == "--threads") && hasValue)
+                options.threadCount = std::stoul(argv[++i]);
+            else if (arg == "--max-instructions" && hasValue)
+                options.maxInstructionsPerPath = std::stoull(argv[++i]);
+            else if (arg == "--scene" && hasValue)
+                scenes.emplace_back(argv[++i]);
+            else if (arg == "--json")
+                json = true;
+            else
+            {
+                usage();
+                return 1;
+            }
+        }
+
+        DxExplorer explorer(DxData::fromFile(filename), options);
+
+        auto start = std::chrono::steady_clock::now();
+        auto report = scenes.empty() ? explorer.explore() : explorer.explore(scenes);
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (json)
+            write_json(std::cout, report);
+        else
+        {
+            write_text(std::cout, report);
+            std::cout << DxFormat("Finished in {:.3f}s\n", elapsed);
+        }
+    }
+    catch (const diannex_exception& ex)
+    {
+        std::cerr << "[Diannex::Explorer]: " << ex.what() << std::endl;
+        return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        // Thrown by the numeric options when their value isn't a number
+        std::cerr << "[Diannex::Explorer]: " << ex.what() << std::endl;
+        usage();
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXCODETABLE_HPP
+#define LIBDIANNEX_DXCODETABLE_HPP
+
+#include "common.hpp"
+#include "models.hpp"
+
+namespace diannex
+{
+    /**
+     * Metadata of every scene (or every function) in a binary, stored column by column. The flags of entry `id` are
+     * the range `[m_flagBegin[id], m_flagBegin[id + 1])` of the flag columns, so every lookup by handle is plain
+     * indexing, with nothing copied.
+     *
+     * The table only holds what the binary says, and is never written to once loaded: flag names are evaluated by
+     * every interpreter for itself, into a `DxFlagNames`.
+     */
+    template<class Id>
+    class DxCodeTable
+    {
+        DxVec<DxStrRef> m_names{};
+        DxVec<int32_t> m_codeOffsets{};
+        DxVec<uint32_t> m_flagBegin{ 0 };
+        DxVec<int32_t> m_flagValueOffsets{};
+        DxVec<int32_t> m_flagNameOffsets{};
+
+        [[nodiscard]] static constexpr size_t index(Id id)
+        { return (size_t)id; }
+
+    public:
+        void reserve(size_t count)
+        {
+            m_names.reserve(count);
+            m_codeOffsets.reserve(count);
+            m_flagBegin.reserve(count + 1);
+        }
+
+        /** Adds an entry with `flagOffsets` laid out as in the binary: value and name expression, for each flag. */
+        Id add(DxStrRef name, int32_t codeOffset, DxROSpan<int32_t> flagOffsets)
+        {
+            auto id = (Id)m_names.size();
+            m_names.push_back(name);
+            m_codeOffsets.push_back(codeOffset);
+            for (size_t i = 0; i + 1 < flagOffsets.size(); i += 2)
+            {
+                m_flagValueOffsets.push_back(flagOffsets[i]);
+                m_flagNameOffsets.push_back(flagOffsets[i + 1]);
+            }
+            m_flagBegin.push_back((uint32_t)m_flagValueOffsets.size());
+            return id;
+        }
+
+        [[nodiscard]] size_t size() const
+        { return m_names.size(); }
+
+        [[nodiscard]] DxROSpan<DxStrRef> names() const
+        { return m_names; }
+
+        [[nodiscard]] DxStrRef name(Id id) const
+        { return m_names[index(id)]; }
+
+        [[nodiscard]] int32_t codeOffset(Id id) const
+        { return m_codeOffsets[index(id)]; }
+
+        /** Position of the first flag of `id` in the flag columns. */
+        [[nodiscard]] size_t flagBegin(Id id) const
+        { return m_flagBegin[index(id)]; }
+
+        [[nodiscard]] size_t totalFlagCount() const
+        { return m_flagValueOffsets.size(); }
+
+        [[nodiscard]] size_t flagCount(Id id) const
+        { return m_flagBegin[index(id) + 1] - flagBegin(id); }
+
+        [[nodiscard]] DxROSpan<int32_t> flagValueOffsets(Id id) const
+        { return DxROSpan<int32_t>{ m_flagValueOffsets }.subspan(flagBegin(id), flagCount(id)); }
+
+        [[nodiscard]] DxROSpan<int32_t> flagNameOffsets(Id id) const
+        { return DxROSpan<int32_t>{ m_flagNameOffsets }.subspan(flagBegin(id), flagCount(id)); }
+
+    };
+
+    /**
+     * Flag names of a code table as one interpreter evaluated them, laid out like the table's flag columns. An entry
+     * is set up the first time the interpreter enters it, or all at once by `DxInterpreter::initializeFlags`; `ready`
+     * tells which.
+     */
+    template<class Id>
+    class DxFlagNames
+    {
+        DxVec<DxStr> m_names{};
+        DxVec<uint8_t> m_ready{};
+
+    public:
+        [[nodiscard]] bool ready(Id id) const
+        { return (size_t)id < m_ready.size() && m_ready[(size_t)id] != 0; }
+
+        /** Names of a `ready` entry. */
+        [[nodiscard]] DxROSpan<DxStr> names(const DxCodeTable<Id>& table, Id id) const
+        { return DxROSpan<DxStr>{ m_names }.subspan(table.flagBegin(id), table.flagCount(id)); }
+
+        /** Where the names of `id` go, until it is marked `setReady`. */
+        [[nodiscard]] DxSpan<DxStr> prepare(const DxCodeTable<Id>& table, Id id)
+        {
+            m_names.resize(table.totalFlagCount());
+            m_ready.resize(table.size());
+            return DxSpan<DxStr>{ m_names }.subspan(table.flagBegin(id), table.flagCount(id));
+        }
+
+        void setReady(Id id)
+        { m_ready[(size_t)id] = 1; }
+
+        void clear()
+        {
+            m_names.clear();
+            m_ready.clear();
+        }
+    };
+}
+
+#endif //LIBDIANNEX_DXCODETABLE_HPP
@@ -19,48 +19,306 @@
 
 #include "common.hpp"
 #include "models.hpp"
+#include "DxCodeTable.hpp"
+#include "DxStringTable.hpp"
+#include "DxPager.hpp"
+#include "DxLanguage.hpp"
+#include "DxNameIndex.hpp"
+#include "DxStringPool.hpp"
+
+#include <future>
+#include <mutex>
 
 namespace diannex
 {
+    // Forward Declaration
+    class BinaryReader;
+    class DxDefinitionTable;
+    class DxMappedFile;
+
     class DxData
     {
-        int m_currentCacheID{ -1 };
-
-        DxVec<DxStr> m_strings;
-        DxVec<DxStr> m_translations;
-        DxVec<std::byte> m_instructions;
-        DxVec<DxFunction> m_functions;
-        DxMap<DxStrRef, DxScene> m_scenes;
-        DxMap<DxStrRef, DxDefinition> m_definitions;
-        DxOpt<DxVec<DxStr>> m_originalText;
+        // Languages other than the default one, their text pooled so that strings they share are stored once. Behind a
+        // pointer, so that the data stays movable.
+        struct ResidentLanguages
+        {
+            std::mutex mutex;
+            DxMap<DxStr, DxPtr<DxLanguageSlot>> slots;
+            DxPtr<DxStringPool> pool;
+        };
+
+        // Strings, translations and instructions are views into these: the mapped file or a buffer holding its contents
+        DxPtr<const void> m_storage;
+        DxPtr<const DxMappedFile> m_mapping;
+        DxPtr<DxPager> m_pager;
+        DxVec<int32_t> m_chunkOffsets;
+
+        DxStringTable m_strings;
+        DxPtr<DxLanguageSlot> m_language{ std::make_shared<DxLanguageSlot>() };
+        DxPtr<ResidentLanguages> m_residentLanguages{ std::make_shared<ResidentLanguages>() };
+        DxByteSpan m_instructions;
+        DxCodeTable<DxSceneId> m_sceneTable;
+        DxCodeTable<DxFunctionId> m_functionTable;
+        // Only filled in for binaries without a name index
+        DxMap<DxStrRef, DxSceneId> m_sceneIds;
+        DxNameIndex m_sceneIndex, m_functionIndex, m_definitionIndex;
+        bool m_nameIndexed{ false };
+        // Sorted by name
+        DxVec<DxStrRef> m_definitionNames;
+        DxVec<DxDefinition> m_definitions;
+
+        DxVec<DxSection> m_sections;
+
+        template<class Reader>
+        void readBlocks(Reader& reader, int version, bool internalTranslation, bool translationIndex);
+
+        /**
+         * Uncompressed binaries are used where they are if `inPlace` (which `reader` reads from) is set, and kept
+         * alive through it. `mapping` is for paging, if that is the mapped file.
+         */
+        static DxData load(const DxPtr<BinaryReader>& reader, const DxStrRef& name, DxPtr<const void> inPlace = nullptr,
+                           DxPtr<const DxMappedFile> mapping = nullptr);
+
+        /**
+         * Into the default language, or the resident language named `language` if there is one. `bytes` are the
+         * translation file, kept in `storage`; pooled resident languages copy what they need, so it can be null.
+         */
+        void loadTranslationBuffer(DxPtr<const void> storage, DxByteSpan bytes, const DxStrRef& name,
+                                   const DxOpt<DxStrRef>& language = std::nullopt);
+
+        void pageInChunk(DxPager::Chunk chunk);
+
+        [[nodiscard]] DxVec<DxByteSpan> chunkRanges(DxPager::Chunk chunk) const;
     public:
-        static constexpr int FormatVersion = 4;
-        static constexpr int TranslationFormatVersion = 0;
+        enum class LoadMode
+        {
+            /** Read the whole file into memory. */
+            Read,
+            /**
+             * Map the file into memory instead of reading it, for uncompressed binaries. Only the pages that are used
+             * get loaded, and processes running the same binary share them. The file must not change while loaded.
+             * Compressed binaries are decompressed straight out of the mapping, which is let go of after.
+             */
+            Map
+        };
+
+        /**
+         * Version 5 starts the binary with a directory of sections, so that each can be found without reading the
+         * ones before it. Version 4, a plain run of blocks, is still read.
+         */
+        static constexpr int FormatVersion = 5;
+
+        /** Version 0 is a count and the strings, version 1 adds an index so that they can be used without parsing. */
+        static constexpr int TranslationFormatVersion = 1;
 
         [[nodiscard]] DxStrRef string(size_t idx) const;
 
+        /**
+         * A string of the current language. Only valid until another language is loaded; hold on to `language()`
+         * instead to keep it.
+         */
         [[nodiscard]] DxStrRef translation(size_t idx) const;
 
-        [[nodiscard]] DxScene scene(const DxStrRef& name) const;
+        [[nodiscard]] inline size_t translationCount() const
+        { return language()->translationCount(); }
 
-        [[nodiscard]] const DxMap<DxStrRef, DxScene>& scenes() const;
+        /**
+         * The current default language. It stays intact for as long as it's held on to, even once another one is
+         * loaded.
+         */
+        [[nodiscard]] inline DxPtr<const DxLanguage> language() const
+        { return m_language->current(); }
 
-        [[nodiscard]] DxMap<DxStrRef, DxScene>& scenes_mut();
+        /** Whether `language` is still the current default one, which is cheaper to check than loading `language()`. */
+        [[nodiscard]] inline bool isCurrentLanguage(const DxLanguage& language) const
+        { return m_language->isCurrent(language); }
 
-        [[nodiscard]] DxROSpan<DxFunction> functions() const;
+        /** A resident language, see `loadLanguageFile`. Throws if there is none by that name. */
+        [[nodiscard]] DxPtr<const DxLanguage> language(const DxStrRef& name) const;
 
-        [[nodiscard]] DxSpan<DxFunction> functions_mut();
+        /** Where the resident language `name` is published, or the default language for an empty name. */
+        [[nodiscard]] DxPtr<const DxLanguageSlot> languageSlot(const DxStrRef& name) const;
+
+        [[nodiscard]] DxVec<DxStr> residentLanguages() const;
+
+        [[nodiscard]] DxOpt<DxSceneId> findScene(const DxStrRef& name) const;
+
+        /** Without a name index in the binary, this goes through every function. */
+        [[nodiscard]] DxOpt<DxFunctionId> findFunction(const DxStrRef& name) const;
+
+        /** Index of a definition in `definitions()`. */
+        [[nodiscard]] DxOpt<size_t> findDefinition(const DxStrRef& name) const;
+
+        /**
+         * Whether names are looked up through the perfect hash tables the compiler stored in the binary, rather than
+         * through tables built at load (format version 4 binaries don't have them).
+         */
+        [[nodiscard]] inline bool hasNameIndex() const
+        { return m_nameIndexed; }
+
+        [[nodiscard]] inline const DxCodeTable<DxSceneId>& sceneTable() const
+        { return m_sceneTable; }
+
+        [[nodiscard]] inline DxCodeTable<DxSceneId>& sceneTable_mut()
+        { return m_sceneTable; }
+
+        [[nodiscard]] inline const DxCodeTable<DxFunctionId>& functionTable() const
+        { return m_functionTable; }
+
+        [[nodiscard]] inline DxCodeTable<DxFunctionId>& functionTable_mut()
+        { return m_functionTable; }
 
         [[nodiscard]] DxDefinition definition(const DxStrRef& name) const;
 
+        /** Every definition, sorted by name. */
+        [[nodiscard]] inline DxROSpan<DxDefinition> definitions() const
+        { return m_definitions; }
+
+        /** The names of `definitions()`. */
+        [[nodiscard]] inline DxROSpan<DxStrRef> definitionNames() const
+        { return m_definitionNames; }
+
+        /**
+         * Sorted, shared view of all definitions for the current language. Replaced (not modified) whenever a
+         * translation file is loaded, so interpreters holding the old one can tell by comparing pointers.
+         */
+        [[nodiscard]] inline DxPtr<const DxDefinitionTable> definitionTable() const
+        { return language()->definitionTable(); }
+
         [[nodiscard]] DxByteSpan instructions() const;
 
+        /** The section directory the data was loaded with; empty for format version 4. */
+        [[nodiscard]] inline const DxVec<DxSection>& sections() const
+        { return m_sections; }
+
         [[nodiscard]] inline int cacheID() const
-        { return m_currentCacheID; }
+        { return m_language->id(); }
+
+        /**
+         * Pages the code of scenes and functions (and the text it uses) in as they are entered, keeping no more than
+         * about `bytes` of it resident; the least recently entered are let go of first. Only for uncompressed binaries
+         * loaded with `LoadMode::Map`. Set it up before sharing the data with interpreters on other threads; changing
+         * the budget afterwards is fine.
+         */
+        void residencyBudget(size_t bytes);
+
+        /** Null unless a residency budget is set. */
+        [[nodiscard]] inline const DxPager* pager() const
+        { return m_pager.get(); }
+
+        inline void pageIn(DxSceneId scene)
+        {
+            if (m_pager)
+                pageInChunk((DxPager::Chunk)scene);
+        }
+
+        inline void pageIn(DxFunctionId function)
+        {
+            if (m_pager)
+                pageInChunk((DxPager::Chunk)(m_sceneTable.size() + (size_t)function));
+        }
+
+        /**
+         * Switches to the language in a translation file. The new language is only published once it's completely
+         * loaded, and interpreters pick it up from their next line on, so this is safe while they are running.
+         *
+         * Indexed translation files (format version 1) aren't parsed at all: with `LoadMode::Map`, switching to one
+         * costs about as much as mapping it, and lines are only paged in once shown.
+         */
+        [[maybe_unused]] void loadTranslationFile(const DxStrRef& filename, LoadMode mode = LoadMode::Read);
+
+        /** Like `loadTranslationFile`, from a translation file in memory. The bytes are copied. */
+        [[maybe_unused]] void loadTranslation(DxByteSpan bytes, const DxStrRef& name = "<memory>");
+
+        /** Like `loadTranslationFile`, reading the translation file through `reader` (see `fromReader`). */
+        [[maybe_unused]] void loadTranslation(BinaryReader& reader, const DxStrRef& name = "<stream>");
+
+        /**
+         * `loadTranslationFile` on a background thread, so that switching languages doesn't hold up the caller.
+         * Errors are thrown from the future's `get`, and leave the current language as it is. The data must not be
+         * moved or destroyed until the load finishes; interpreters keep theirs in place.
+         */
+        [[maybe_unused]] std::future<void> loadTranslationAsync(DxStr filename, LoadMode mode = LoadMode::Read);
+
+        /** `loadTranslation` through `reader` on a background thread, see the other overload. */
+        [[maybe_unused]] std::future<void> loadTranslationAsync(DxPtr<BinaryReader> reader, DxStr name = "<stream>");
+
+        /**
+         * Loads a translation file as a resident language, alongside the default language and any other resident ones,
+         * for interpreters that select it by name. Strings it shares with the default language or other resident
+         * languages are only stored once, so memory grows with the text that is unique to it. Loading a name again
+         * replaces that language like `loadTranslationFile` does the default one, though text only the old version
+         * had stays pooled.
+         */
+        [[maybe_unused]] void loadLanguageFile(const DxStrRef& language, const DxStrRef& filename);
+
+        /** Like `loadLanguageFile`, from a translation file in memory. */
+        [[maybe_unused]] void loadLanguage(const DxStrRef& language, DxByteSpan bytes);
+
+        /** Like `loadLanguageFile`, reading the translation file through `reader` (see `fromReader`). */
+        [[maybe_unused]] void loadLanguage(const DxStrRef& language, BinaryReader& reader);
+
+        /** `loadLanguageFile` on a background thread, see `loadTranslationAsync`. */
+        [[maybe_unused]] std::future<void> loadLanguageAsync(DxStr language, DxStr filename);
+
+        static DxData fromFile(const DxStrRef& filename, LoadMode mode = LoadMode::Read);
+
+        /**
+         * Loads a binary that is already in memory. The bytes are copied (or inflated, if compressed), so they can be
+         * let go of as soon as this returns. `name` is only used in error messages.
+         */
+        static DxData fromMemory(DxByteSpan bytes, const DxStrRef& name = "<memory>");
+
+        /**
+         * Loads a binary from any other source, such as a file inside a pack archive, read front to back through
+         * `reader`. Derive from `BinaryReader` and implement `read_n` and `skip` on top of the source to plug it in.
+         * `name` is only used in error messages.
+         */
+        static DxData fromReader(DxPtr<BinaryReader> reader, const DxStrRef& name = "<stream>");
+
+        /**
+         * Reads the content of a single section of a format version 5 binary, skipping everything else, without
+         * loading the binary. Throws if there is no such section.
+         */
+        static DxByteBuf readSection(const DxStrRef& filename, DxSectionType type);
+
+        /** Like the other overload, reading the binary through `reader` (see `fromReader`). */
+        static DxByteBuf readSection(BinaryReader& reader, DxSectionType type, const DxStrRef& name = "<stream>");
+
+        /**
+         * Decodes the binary `filename` once into the new shared memory segment `segment` (see `DxSharedImage` for
+         * names and lifetime), then loads it from there like `fromSharedImage`. Throws if the segment exists already.
+         *
+         * The image is the binary uncompressed, plus a string offsets section for format version 5 binaries so that
+         * the string tables are used in place. Everything in it is an offset, so each process can map it anywhere.
+         */
+        static DxData publishSharedImage(const DxStrRef& filename, const DxStrRef& segment);
+
+        /**
+         * Loads the binary from a segment written by `publishSharedImage`, possibly in another process. The segment
+         * is mapped read-only and used in place: nothing is decompressed or copied, and the text and bytecode are
+         * stored once for all processes on the host. Only the scene, function and definition tables are built, per
+         * process.
+         */
+        static DxData fromSharedImage(const DxStrRef& segment);
+
+        /** Removes a segment written by `publishSharedImage`, see `DxSharedImage::remove`. */
+        static bool removeSharedImage(const DxStrRef& segment);
+
+        /** `fromFile` on a background thread. Errors are thrown from the future's `get`. */
+        static std::future<DxData> loadAsync(DxStr filename, LoadMode mode = LoadMode::Read);
+
+        /** `fromReader` on a background thread. The reader is only used by that thread until the load finishes. */
+        static std::future<DxData> loadAsync(DxPtr<BinaryReader> reader, DxStr name = "<stream>");
 
-        [[maybe_unused]] void loadTranslationFile(const DxStrRef& filename);
+        /**
+         * Binaries of at least this many bytes (1 MiB by default) are inflated and decoded on several threads, when
+         * the machine has more than one core. 0 always uses threads, e.g. to exercise that path with small binaries.
+         * Applies to every load started afterwards, on any thread.
+         */
+        [[maybe_unused]] static void parallelLoadThreshold(size_t bytes);
 
-        static DxData fromFile(const DxStrRef& filename);
+        [[nodiscard, maybe_unused]] static size_t parallelLoadThreshold();
     };
 }
 
@@ -0,0 +1,73 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXDEFINITIONTABLE_HPP
+#define LIBDIANNEX_DXDEFINITIONTABLE_HPP
+
+#include "common.hpp"
+#include "models.hpp"
+
+namespace diannex
+{
+    // Forward Declaration
+    class DxData;
+    class DxLanguage;
+
+    /**
+     * Every definition of a `DxData`, sorted by name so that a namespace prefix (e.g. `menu.`) is one contiguous
+     * range. Built once per language, as part of its `DxLanguage`, and shared read-only by all interpreters running
+     * that data.
+     *
+     * Definitions without code have their final value right here. Those with code (interpolated definitions) only have
+     * their template string, they're evaluated by each interpreter, as the result depends on its handlers.
+     */
+    class DxDefinitionTable
+    {
+        int m_cacheID;
+        DxVec<DxStrRef> m_names{};
+        DxVec<DxDefinition> m_definitions{};
+        DxVec<DxStrRef> m_values{};
+
+    public:
+        DxDefinitionTable(const DxData& data, const DxLanguage& language);
+
+        [[nodiscard]] inline int cacheID() const
+        { return m_cacheID; }
+
+        [[nodiscard]] inline size_t size() const
+        { return m_names.size(); }
+
+        [[nodiscard]] DxOpt<size_t> find(const DxStrRef& name) const;
+
+        /** Index range `[first, second)` of all definitions whose name starts with `prefix`. */
+        [[nodiscard]] std::pair<size_t, size_t> prefix(const DxStrRef& prefix) const;
+
+        [[nodiscard]] inline DxROSpan<DxStrRef> names() const
+        { return m_names; }
+
+        [[nodiscard]] inline const DxDefinition& definition(size_t idx) const
+        { return m_definitions[idx]; }
+
+        /** The value of a definition, or its template string if `isDynamic`. */
+        [[nodiscard]] inline DxROSpan<DxStrRef> values() const
+        { return m_values; }
+
+        [[nodiscard]] inline bool isDynamic(size_t idx) const
+        { return m_definitions[idx].codeOffset != -1; }
+    };
+}
+
+#endif //LIBDIANNEX_DXDEFINITIONTABLE_HPP
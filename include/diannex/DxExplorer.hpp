@@ -0,0 +1,113 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXEXPLORER_HPP
+#define LIBDIANNEX_DXEXPLORER_HPP
+
+#include "DxInterpreter.hpp"
+
+namespace diannex
+{
+    struct DxExplorerOptions
+    {
+        // Number of worker threads; 0 uses std::thread::hardware_concurrency()
+        unsigned int threadCount{ 0 };
+        // A path that runs for longer than this is assumed to be stuck in a loop and is cut off
+        size_t maxInstructionsPerPath{ 1'000'000 };
+        // Keep the functions registered on the prototype interpreter instead of stubbing every native.
+        // Only enable this if those functions are safe to call from several threads at once
+        bool useRegisteredFunctions{ false };
+    };
+
+    enum class DxPathEnd
+    {
+        SceneEnd,
+        Merged, // Reached a branch point in exactly the state another path already explored
+        InstructionLimit,
+        Error
+    };
+
+    struct DxExplorerPath
+    {
+        // Index into DxExplorerReport::scenes
+        size_t scene{};
+        // Option index taken at each choice/choose statement, in the order they were encountered
+        DxVec<int> decisions{};
+        size_t instructionCount{};
+        DxPathEnd end{ DxPathEnd::SceneEnd };
+        DxStr error{};
+    };
+
+    struct DxExplorerBranch
+    {
+        // Index into DxExplorerReport::scenes
+        size_t scene{};
+        int targetOffset{};
+        bool isChoice{};
+    };
+
+    struct DxExplorerReport
+    {
+        DxVec<DxStr> scenes{};
+        // Translation string indices pushed by any explored path, sorted
+        DxVec<size_t> reachableText{};
+        // Choice/choose options that were reached but never available on any path
+        DxVec<DxExplorerBranch> deadBranches{};
+        DxVec<DxExplorerPath> paths{};
+    };
+
+    /**
+     * Exhaustively explores the dialogue graph of every scene, branching on every choice and choose option.
+     *
+     * Each path runs on a fork of the prototype interpreter with its own variable and flag store, and paths are spread
+     * across a pool of worker threads. States are memoised at branch points by an encoding of the whole VM state and
+     * store, compared in full, so paths that converge on the same state are only explored once. States holding a
+     * reference (a value from a native the explorer can't look into) are never merged.
+     */
+    class DxExplorer
+    {
+        struct Environment;
+        struct WorkItem;
+        struct SharedState;
+
+        DxInterpreter m_prototype;
+        DxExplorerOptions m_options;
+        DxPtr<Environment> m_rootEnvironment;
+    public:
+        explicit DxExplorer(const DxInterpreter& prototype, DxExplorerOptions options = {});
+
+        explicit DxExplorer(DxData&& data, DxExplorerOptions options = {});
+
+        DxExplorerReport explore();
+
+        DxExplorerReport explore(const DxVec<DxStrRef>& sceneNames);
+
+    private:
+        void prepare();
+
+        static void bind(DxInterpreter& interpreter, const DxPtr<Environment>& env);
+
+        static WorkItem branch(const WorkItem& item, int decision);
+
+        static void select(WorkItem& item, bool isChoice, int option);
+
+        static bool stateKey(const DxInterpreter& interpreter, const Environment& env, DxStr& key);
+
+        void run(WorkItem item, SharedState& shared) const;
+    };
+}
+
+#endif //LIBDIANNEX_DXEXPLORER_HPP
@@ -17,6 +17,8 @@
 #ifndef LIBDIANNEX_DXINSTRUCTIONS_HPP
 #define LIBDIANNEX_DXINSTRUCTIONS_HPP
 
+#include <string_view>
+
 namespace diannex
 {
     enum class [[maybe_unused]] DxOpcode : unsigned char
@@ -98,6 +100,158 @@ namespace diannex
 
         textrun = 0x4E, // Pauses the interpreter, running a line of text from the stack
     };
+
+    constexpr std::string_view opcode_name(DxOpcode opcode)
+    {
+        switch (opcode)
+        {
+            case DxOpcode::nop:
+                return "nop";
+            case DxOpcode::freeloc:
+                return "freeloc";
+            case DxOpcode::save:
+                return "save";
+            case DxOpcode::load:
+                return "load";
+            case DxOpcode::pushu:
+                return "pushu";
+            case DxOpcode::pushi:
+                return "pushi";
+            case DxOpcode::pushd:
+                return "pushd";
+            case DxOpcode::pushs:
+                return "pushs";
+            case DxOpcode::pushints:
+                return "pushints";
+            case DxOpcode::pushbs:
+                return "pushbs";
+            case DxOpcode::pushbints:
+                return "pushbints";
+            case DxOpcode::makearr:
+                return "makearr";
+            case DxOpcode::pusharrind:
+                return "pusharrind";
+            case DxOpcode::setarrind:
+                return "setarrind";
+            case DxOpcode::setvarglb:
+                return "setvarglb";
+            case DxOpcode::setvarloc:
+                return "setvarloc";
+            case DxOpcode::pushvarglb:
+                return "pushvarglb";
+            case DxOpcode::pushvarloc:
+                return "pushvarloc";
+            case DxOpcode::pop:
+                return "pop";
+            case DxOpcode::dup:
+                return "dup";
+            case DxOpcode::dup2:
+                return "dup2";
+            case DxOpcode::add:
+                return "add";
+            case DxOpcode::sub:
+                return "sub";
+            case DxOpcode::mul:
+                return "mul";
+            case DxOpcode::div:
+                return "div";
+            case DxOpcode::mod:
+                return "mod";
+            case DxOpcode::neg:
+                return "neg";
+            case DxOpcode::inv:
+                return "inv";
+            case DxOpcode::bitls:
+                return "bitls";
+            case DxOpcode::bitrs:
+                return "bitrs";
+            case DxOpcode::_bitand:
+                return "bitand";
+            case DxOpcode::_bitor:
+                return "bitor";
+            case DxOpcode::bitxor:
+                return "bitxor";
+            case DxOpcode::bitneg:
+                return "bitneg";
+            case DxOpcode::pow:
+                return "pow";
+            case DxOpcode::cmpeq:
+                return "cmpeq";
+            case DxOpcode::cmpgt:
+                return "cmpgt";
+            case DxOpcode::cmplt:
+                return "cmplt";
+            case DxOpcode::cmpgte:
+                return "cmpgte";
+            case DxOpcode::cmplte:
+                return "cmplte";
+            case DxOpcode::cmpneq:
+                return "cmpneq";
+            case DxOpcode::j:
+                return "j";
+            case DxOpcode::jt:
+                return "jt";
+            case DxOpcode::jf:
+                return "jf";
+            case DxOpcode::exit:
+                return "exit";
+            case DxOpcode::ret:
+                return "ret";
+            case DxOpcode::call:
+                return "call";
+            case DxOpcode::callext:
+                return "callext";
+            case DxOpcode::choicebeg:
+                return "choicebeg";
+            case DxOpcode::choiceadd:
+                return "choiceadd";
+            case DxOpcode::choiceaddt:
+                return "choiceaddt";
+            case DxOpcode::choicesel:
+                return "choicesel";
+            case DxOpcode::chooseadd:
+                return "chooseadd";
+            case DxOpcode::chooseaddt:
+                return "chooseaddt";
+            case DxOpcode::choosesel:
+                return "choosesel";
+            case DxOpcode::textrun:
+                return "textrun";
+            default:
+                return "unknown";
+        }
+    }
+
+    /** Size in bytes of the operands that follow `opcode` in the bytecode. */
+    constexpr int operand_size(DxOpcode opcode)
+    {
+        switch (opcode)
+        {
+            case DxOpcode::freeloc:
+            case DxOpcode::pushi:
+            case DxOpcode::pushs:
+            case DxOpcode::pushbs:
+            case DxOpcode::makearr:
+            case DxOpcode::setvarloc:
+            case DxOpcode::pushvarloc:
+            case DxOpcode::j:
+            case DxOpcode::jt:
+            case DxOpcode::jf:
+            case DxOpcode::choiceadd:
+            case DxOpcode::choiceaddt:
+            case DxOpcode::chooseadd:
+            case DxOpcode::chooseaddt:
+                return 4;
+            case DxOpcode::pushd:
+            case DxOpcode::pushints:
+            case DxOpcode::pushbints:
+            case DxOpcode::call:
+            case DxOpcode::callext:
+                return 8;
+            default:
+                return 0;
+        }
+    }
 }
 
 #endif //LIBDIANNEX_DXINSTRUCTIONS_HPP
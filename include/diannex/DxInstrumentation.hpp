@@ -0,0 +1,77 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXINSTRUMENTATION_HPP
+#define LIBDIANNEX_DXINSTRUMENTATION_HPP
+
+#include "common.hpp"
+#include "models.hpp"
+#include "DxValue.hpp"
+#include "DxInstructions.hpp"
+
+namespace diannex
+{
+    // Forward Declaration
+    class DxInterpreter;
+
+    /**
+     * Compile-time hooks into the interpreter loop. Pass a policy type to the templated `interpret`, `runScene`,
+     * `resumeScene`, `selectChoice`, `step` or `runFor` overloads of `DxInterpreter` (e.g.
+     * `interpreter.runScene<MyPolicy>("area0.intro")`) to have its static hooks called inline as the scene runs.
+     *
+     * The untemplated overloads run with `DxNoInstrumentation`, whose hooks are empty and vanish entirely once inlined.
+     * To only implement some hooks, derive from it and hide the ones you need.
+     */
+    template<class Policy>
+    concept DxInstrumentationPolicy = requires(DxInterpreter& interpreter,
+                                               int programCounter,
+                                               DxOpcode opcode,
+                                               DxStrRef name,
+                                               const DxVec<DxValue>& args,
+                                               const DxStr& text)
+    {
+        Policy::onInstruction(interpreter, programCounter, opcode);
+        Policy::onCall(interpreter, name);
+        Policy::onReturn(interpreter);
+        Policy::onCallExt(interpreter, name, args);
+        Policy::onText(interpreter, text);
+    };
+
+    struct DxNoInstrumentation
+    {
+        /** Before an instruction executes, `programCounter` being the offset of its opcode. */
+        static void onInstruction(DxInterpreter&, int, DxOpcode)
+        {}
+
+        /** After a call has entered the function `name`, with its flags and arguments already loaded. */
+        static void onCall(DxInterpreter&, DxStrRef)
+        {}
+
+        /** When a function returns to its caller (through `ret` or `exit`). Not raised for the end of a scene. */
+        static void onReturn(DxInterpreter&)
+        {}
+
+        /** Right before a registered (or unregistered) external function is called. */
+        static void onCallExt(DxInterpreter&, DxStrRef, const DxVec<DxValue>&)
+        {}
+
+        /** Right before the text handler receives a line of text. */
+        static void onText(DxInterpreter&, const DxStr&)
+        {}
+    };
+}
+
+#endif //LIBDIANNEX_DXINSTRUMENTATION_HPP
@@ -18,9 +18,16 @@
 #define LIBDIANNEX_DXINTERPRETER_HPP
 
 #include "DxData.hpp"
+#include "DxDefinitionTable.hpp"
+#include "DxProfiler.hpp"
+#include "DxInstrumentation.hpp"
 #include "utils/DxStack.hpp"
+#include "utils/DxCow.hpp"
 #include "internal/DxValueConcepts.hpp"
 
+#include <chrono>
+#include <cstring>
+
 namespace diannex
 {
     // Forward Declaration
@@ -28,22 +35,6 @@ namespace diannex
 
     namespace _internal
     {
-        class DxDefinitionInstance
-        {
-            DxDefinition m_target;
-            DxWeakPtr<DxData> m_data;
-            DxWeakPtr<DxInterpreter> m_interpreter;
-
-            DxOpt<DxStr> m_cachedValue{ std::nullopt };
-            int m_cachedId{ -1 };
-        public:
-            DxDefinitionInstance(DxDefinition target, DxWeakPtr<DxData> data, DxWeakPtr<DxInterpreter> interpreter);
-
-            DxStrRef value();
-
-            DxStrRef valueNoCache();
-        };
-
         template<class Expected, class Actual>
         auto make_copyable_functor(Actual&& func) -> Expected
         {
@@ -58,13 +49,14 @@ namespace diannex
         concept constructible_to = std::constructible_from<OutT, InT>;
     }
 
-    class DxInterpreter : std::enable_shared_from_this<DxInterpreter>
+    class DxInterpreter
     {
         using DxFuncSig = DxFunc<DxValue(const DxVec<DxValue>&)>;
         using DxFuncMap = DxMap<DxStrRef, DxFuncSig>;
 
-        friend class _internal::DxDefinitionInstance;
+        friend class DxExplorer;
 
+    public:
         enum class State
         {
             Inactive,
@@ -72,17 +64,24 @@ namespace diannex
             Paused,
             InText,
             InChoice,
-            Eval
+            Eval,
+            Suspended // Ran out of its instruction/time budget, continue with `step` or `runFor`
         };
 
+    private:
+        using ValueStack = DxStack<DxValue, DxPmrVec<DxValue>>;
+
         struct StackFrame
         {
             int returnOffset{};
-            DxStack<DxValue> stack{};
-            DxVec<DxValue> locals{};
+            DxCow<ValueStack> stack{};
+            DxCow<DxPmrVec<DxValue>> locals{};
             int flagCount{};
+            DxOpt<DxFunctionId> function{};
         };
 
+        using FrameStack = DxStack<StackFrame, DxPmrVec<StackFrame>>;
+
         struct ChoiceEntry
         {
             int targetOffset{};
@@ -96,21 +95,39 @@ namespace diannex
         };
 
         DxPtr<DxData> m_data;
-        DxFuncMap m_functionHandlers{};
+        DxCow<DxFuncMap> m_functionHandlers{};
 
         State m_state{ State::Inactive };
         int m_programCounter{ -1 };
-        DxStack<DxValue> m_stack{};
-        DxStack<StackFrame> m_callStack{};
-        DxVec<DxValue> m_locals{};
+        DxCow<ValueStack> m_stack{};
+        DxCow<FrameStack> m_callStack{};
+        DxCow<DxPmrVec<DxValue>> m_locals{};
         DxVec<ChoiceEntry> m_choiceOptions{};
         DxVec<ChooseEntry> m_chooseOptions{};
         DxOpt<DxValue> m_saveRegister{ std::nullopt };
         int m_flagCount{ 0 };
-        DxOpt<DxScene> m_currentScene{ std::nullopt };
+        DxOpt<DxSceneId> m_currentScene{ std::nullopt };
+        DxOpt<DxFunctionId> m_currentFunction{ std::nullopt };
         bool m_startingChoice{ false };
-        DxMap<DxStrRef, _internal::DxDefinitionInstance> m_definitions{};
+        DxPtr<const DxLanguageSlot> m_languageSlot;
+        DxStr m_languageName{};
+        DxPtr<const DxLanguage> m_language{};
+        DxPtr<const DxDefinitionTable> m_definitionTable{};
+        DxVec<DxStrRef> m_definitionValues{};
+        DxVec<DxStr> m_definitionStorage{};
+        DxVec<bool> m_definitionResolved{};
+        DxMap<DxStr, DxVec<size_t>> m_globalDependents{};
+        DxMap<DxStr, DxVec<size_t>> m_nativeDependents{};
+        size_t m_evaluatingDefinition{};
         bool m_flagsInitialized{ false };
+        DxCow<DxFlagNames<DxSceneId>> m_sceneFlags{};
+        DxCow<DxFlagNames<DxFunctionId>> m_functionFlags{};
+        DxPtr<DxData> m_pendingData{};
+        DxPtr<const DxLanguageSlot> m_pendingLanguageSlot{};
+        DxMemoryResource* m_memoryResource{ std::pmr::get_default_resource() };
+        #ifdef DIANNEX_PROFILER
+        DxProfiler m_profiler{};
+        #endif
     public:
         template<DxCoercableTo R, DxCoercableFrom... Args, std::size_t... Is>
         static DxValue registerFunctionImpl(
@@ -147,26 +164,207 @@ namespace diannex
 
         explicit DxInterpreter(DxData&& data);
 
+        DxInterpreter(DxInterpreter&& other) noexcept = default;
+
+        DxInterpreter& operator=(DxInterpreter&& other) noexcept = default;
+
+        DxInterpreter& operator=(const DxInterpreter& other) = delete;
+
+        /**
+         * Creates an independent copy of this interpreter, in whatever state it is currently in (e.g. paused at a
+         * choice), that can be run forward separately.
+         *
+         * This is O(1): the stack, call stack and locals are shared with the original and only copied once either side
+         * writes to them. Handlers, the loaded data and its definition table are shared as well; evaluated definitions
+         * and profiler data are not. The default variable and flag stores are copied, so that what the fork sets with
+         * them isn't seen by the original and the other way around. The fork uses the default memory resource, see
+         * `memoryResource`.
+         */
+        [[nodiscard]] DxInterpreter fork() const;
+
+        void interpret(DxByteSpan buff);
+
+        template<DxInstrumentationPolicy Policy>
         void interpret(DxByteSpan buff);
 
+        /**
+         * Resolves a scene name once, for the allocation and hash free `runScene`/`startScene` overloads.
+         */
+        [[nodiscard, maybe_unused]] DxSceneId sceneId(const DxStrRef& name) const;
+
         void runScene(const DxStrRef& name);
 
+        [[maybe_unused]] void runScene(DxSceneId scene);
+
+        template<DxInstrumentationPolicy Policy>
+        void runScene(const DxStrRef& name);
+
+        template<DxInstrumentationPolicy Policy>
+        void runScene(DxSceneId scene);
+
+        /**
+         * Sets up a scene without running any of it, leaving the interpreter `Suspended` so that it can be driven by
+         * `step` or `runFor`.
+         */
+        [[maybe_unused]] void startScene(const DxStrRef& name);
+
+        [[maybe_unused]] void startScene(DxSceneId scene);
+
         [[maybe_unused]] void pauseScene();
 
         void resumeScene();
 
+        template<DxInstrumentationPolicy Policy>
+        void resumeScene();
+
+        /**
+         * Continues a paused, suspended or text-waiting scene for at most `maxInstructions` instructions.
+         * If the budget runs out before the scene pauses by itself, the interpreter is left `Suspended` and the next
+         * call picks up exactly where this one stopped.
+         */
+        [[maybe_unused]] State step(size_t maxInstructions);
+
+        template<DxInstrumentationPolicy Policy>
+        State step(size_t maxInstructions);
+
+        /**
+         * Same as `step`, but bounded by a point in time instead. The clock is only sampled every
+         * `DeadlineCheckInterval` instructions, so the deadline can be overshot by that many instructions.
+         */
+        [[maybe_unused]] State runFor(std::chrono::steady_clock::time_point deadline);
+
+        template<DxInstrumentationPolicy Policy>
+        State runFor(std::chrono::steady_clock::time_point deadline);
+
+        [[nodiscard, maybe_unused]] inline State state() const
+        { return m_state; }
+
+        /**
+         * The data this interpreter runs, shared with its forks. It stays in place for as long as the interpreter
+         * exists, e.g. for `DxData::loadTranslationAsync`.
+         */
+        [[nodiscard, maybe_unused]] inline DxData& data()
+        { return *m_data; }
+
+        [[nodiscard, maybe_unused]] inline const DxData& data() const
+        { return *m_data; }
+
+        /**
+         * Swaps in a new version of the program, e.g. one recompiled while the game is running, keeping every handler,
+         * registered function and flag. An idle interpreter switches over right away; one in the middle of a scene
+         * finishes it on the data it started it with and switches once it ends. Old data is freed once no interpreter
+         * or fork runs it anymore.
+         *
+         * The selected language is selected again by name, so a resident language has to be loaded into the new data
+         * first. Scene and definition ids have to be resolved again after the switch. Returns whether it switched
+         * right away.
+         */
+        [[maybe_unused]] bool reload(DxData&& data);
+
+        /** Same as the other overload, for one new version shared by several interpreters. */
+        [[maybe_unused]] bool reload(DxPtr<DxData> data);
+
+        /**
+         * Sets where the scenes run from here on allocate their state, e.g. a `std::pmr::monotonic_buffer_resource`
+         * released in one go from the end scene handler, or a pool per worker thread. Only while no scene is running;
+         * the default is `std::pmr::get_default_resource()`.
+         *
+         * That covers the value stack, call stack, locals and call arguments, and the strings and arrays in them,
+         * including joined and interpolated text. Values handed to handlers (variables, flags and arguments of
+         * external functions) are copied onto the global heap first, as handlers may keep them past the scene; so are
+         * the text and choices shown, which handlers get as plain strings.
+         *
+         * Nothing allocated from it is held on to once a scene ended, except by forks made during that scene: they
+         * share this state until they first write to it, so the resource has to outlive them (and be thread safe if
+         * they run on other threads).
+         */
+        [[maybe_unused]] void memoryResource(DxMemoryResource* resource);
+
+        [[nodiscard, maybe_unused]] inline DxMemoryResource* memoryResource() const
+        { return m_memoryResource; }
+
+        /** Whether a `reload` is waiting for the current scene to end. */
+        [[nodiscard, maybe_unused]] inline bool reloadPending() const
+        { return m_pendingData != nullptr; }
+
+        /**
+         * Selects which of the data's languages text and definitions are shown in, from the next line on: one of its
+         * resident languages (see `DxData::loadLanguageFile`), or its default language for an empty name. Forks start
+         * out in the language of the interpreter they were forked from.
+         */
+        [[maybe_unused]] void language(const DxStrRef& name);
+
+        /** The language currently selected. */
+        [[nodiscard, maybe_unused]] inline DxPtr<const DxLanguage> language() const
+        { return m_languageSlot->current(); }
+
         void endScene();
 
         void selectChoice(int idx);
 
+        template<DxInstrumentationPolicy Policy>
+        void selectChoice(int idx);
+
+        /**
+         * Selects a choice like `selectChoice`, but leaves the interpreter `Suspended` at the chosen branch instead of
+         * running it.
+         */
+        [[maybe_unused]] void selectChoiceDeferred(int idx);
+
+        struct DefinitionRange
+        {
+            DxROSpan<DxStrRef> names;
+            DxROSpan<DxStrRef> values;
+        };
+
+        /**
+         * Resolves a definition name once, for the hash free `definition` overload. Ids are the same for every
+         * language of the same binary.
+         */
+        [[nodiscard, maybe_unused]] DxDefinitionId definitionId(const DxStrRef& name) const;
+
         [[maybe_unused]] DxStrRef definition(const DxStrRef& name);
 
+        [[maybe_unused]] DxStrRef definition(DxDefinitionId id);
+
+        /**
+         * Evaluates every definition whose name starts with `prefix` (e.g. `menu.`) in one pass, returning their names
+         * and values in matching order, sorted by name.
+         *
+         * Values of definitions without code are shared with every other interpreter, those with code are evaluated
+         * once by this interpreter and cached until one of their inputs is invalidated (see `invalidateGlobal`). The
+         * names stay valid until a different translation is loaded, a value until its definition is evaluated again.
+         */
+        [[maybe_unused]] DefinitionRange definitions(const DxStrRef& prefix);
+
+        /**
+         * Reports that global variable `name` changed. Definitions that read it the last time they were evaluated are
+         * evaluated again on next use; everything else keeps its cached value.
+         */
+        [[maybe_unused]] void invalidateGlobal(const DxStrRef& name);
+
+        /**
+         * Reports that external function `name` would now return something different, see `invalidateGlobal`.
+         */
+        [[maybe_unused]] void invalidateNative(const DxStrRef& name);
+
+        /**
+         * Re-evaluates every definition with code on next use, for changes that can't be pinned down to a name.
+         */
+        [[maybe_unused]] void invalidateDefinitions();
+
         DxValue executeEval(int address);
 
         void executeEvalMultiple(int address);
 
+        template<DxInstrumentationPolicy Policy>
+        void executeEvalMultiple(int address);
+
         static DxStr interpolate(const DxStrRef& str, const DxROSpan<DxStr>& elems);
 
+        /** Same as the other overload, with the text allocated from `resource`. */
+        static DxPmrStr interpolate(const DxStrRef& str, const DxROSpan<DxPmrStr>& elems, DxMemoryResource* resource);
+
         void registerFunctionSafe(const DxStrRef& name, const DxFuncSig& func);
 
         template<typename R, DxCoercableFrom... Args>
@@ -212,6 +410,13 @@ namespace diannex
 
         [[maybe_unused]] DxInterpreter& flagGetHandler(GetFlagCallback func);
 
+        /**
+         * Flags of a scene or function are set up the first time this interpreter enters it: their names are evaluated,
+         * and their default values are stored through the flag handlers unless the flag already has a value. This does
+         * the same for every scene and function up front, e.g. as a warmup before the interpreter is used or forked
+         * (forks start out with the flags of the interpreter they were forked from set up). Calling it a second time
+         * resets all flags, like `resetFlags`.
+         */
         bool initializeFlags();
 
         void resetFlags();
@@ -220,6 +425,13 @@ namespace diannex
 
         [[maybe_unused]] static int random_int(int min = 0, int max = std::numeric_limits<int>::max());
 
+        static constexpr size_t DeadlineCheckInterval = 32;
+
+        #ifdef DIANNEX_PROFILER
+        [[nodiscard, maybe_unused]] DxProfiler& profiler()
+        { return m_profiler; }
+        #endif
+
     private:
         UnregisteredFunctionCallback m_unregisteredFunctionHandler;
         TextCallback m_textHandler;
@@ -232,10 +444,80 @@ namespace diannex
         GetFlagCallback m_getFlagHandler;
         ChoiceCallback m_choiceHandler;
 
+        DxInterpreter(const DxInterpreter& other);
+
         void assert_state(State state, const DxStrRef& message);
 
         void clearVMState();
 
+        void releaseVMState();
+
+        [[nodiscard]] inline DxCow<ValueStack> makeStack() const
+        { return { ValueStack{ DxPmrVec<DxValue>{ m_memoryResource } }, m_memoryResource }; }
+
+        [[nodiscard]] inline DxCow<DxPmrVec<DxValue>> makeLocals() const
+        { return { DxPmrVec<DxValue>{ m_memoryResource }, m_memoryResource }; }
+
+        /** Copies a value within a scene, keeping its string or array on the memory resource. */
+        [[nodiscard]] inline DxValue scoped(const DxValue& value) const
+        { return value.copy(m_memoryResource); }
+
+        /** Takes a value handed to a handler off the memory resource, as the handler may keep it past the scene. */
+        [[nodiscard]] inline DxValue exported(DxValue value) const
+        {
+            if (m_memoryResource == std::pmr::get_default_resource())
+                return value;
+            return value.copy(std::pmr::get_default_resource());
+        }
+
+        bool enterScene(DxSceneId scene);
+
+        void swapData();
+
+        DxValue evaluateNested(int address);
+
+        template<class Id>
+        void prepareFlags(const DxCodeTable<Id>& table, DxFlagNames<Id>& flags, Id id);
+
+        void prepareAllFlags();
+
+        /** Picks up a new version of the selected language, if one was loaded, so that lines from here on use it. */
+        inline void syncLanguage()
+        {
+            if (!m_language || !m_languageSlot->isCurrent(*m_language))
+                m_language = m_languageSlot->current();
+        }
+
+        void syncDefinitions();
+
+        DxStrRef resolveDefinition(size_t idx);
+
+        void addDependency(DxMap<DxStr, DxVec<size_t>>& dependents, const DxStrRef& name);
+
+        void invalidateDependents(DxMap<DxStr, DxVec<size_t>>& dependents, const DxStrRef& name);
+
+        /**
+         * Records the globals and external functions read while a definition is evaluated, so that it only has to be
+         * evaluated again once one of those is invalidated.
+         */
+        struct DependencyTracker : DxNoInstrumentation
+        {
+            static void onInstruction(DxInterpreter& interpreter, int offset, DxOpcode opcode)
+            {
+                // Runs before the instruction, so its name argument is read straight from the code
+                if (opcode == DxOpcode::pushvarglb)
+                {
+                    int32_t nameIdx;
+                    std::memcpy(&nameIdx, interpreter.m_data->instructions().data() + offset + sizeof(DxOpcode),
+                                sizeof(nameIdx));
+                    interpreter.addDependency(interpreter.m_globalDependents, interpreter.m_data->string(nameIdx));
+                }
+            }
+
+            static void onCallExt(DxInterpreter& interpreter, DxStrRef name, const DxVec<DxValue>&)
+            { interpreter.addDependency(interpreter.m_nativeDependents, name); }
+        };
+
         template<typename R, typename... Args>
         auto stub(const std::string_view& message) -> DxFunc<R(Args...)>
         {
@@ -255,4 +537,6 @@ namespace diannex
     };
 }
 
+#include "internal/DxInterpreterImpl.hpp"
+
 #endif //LIBDIANNEX_DXINTERPRETER_HPP
@@ -0,0 +1,105 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXLANGUAGE_HPP
+#define LIBDIANNEX_DXLANGUAGE_HPP
+
+#include "common.hpp"
+#include "DxStringTable.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace diannex
+{
+    // Forward Declaration
+    class DxData;
+    class DxDefinitionTable;
+
+    /**
+     * The text of one language: its translations, and the definitions resolved against them. Never modified once
+     * built, so it can be read from any thread. Loading a translation file builds a new one and publishes it in place
+     * of the current one, which stays valid for as long as anyone still holds on to it.
+     */
+    class DxLanguage
+    {
+        int m_id;
+        DxPtr<const void> m_storage;
+        DxStringTable m_translations;
+        DxVec<const char*> m_pooled;
+        DxPtr<const DxDefinitionTable> m_definitionTable;
+
+    public:
+        /** `translations` are views into `storage`, which is kept alive along with them. */
+        DxLanguage(const DxData& data, DxPtr<const void> storage, DxStringTable translations);
+
+        /**
+         * A language of null-terminated strings that are stored elsewhere, usually a `DxStringPool` shared with other
+         * languages. `storage` is kept alive along with them.
+         */
+        DxLanguage(const DxData& data, DxPtr<const void> storage, DxVec<const char*> translations);
+
+        /** Unique to this language among all that get built while the process runs. */
+        [[nodiscard]] inline int id() const
+        { return m_id; }
+
+        [[nodiscard]] inline size_t translationCount() const
+        { return m_pooled.empty() ? m_translations.size() : m_pooled.size(); }
+
+        [[nodiscard]] inline DxStrRef translation(size_t idx) const
+        {
+            if (m_pooled.empty())
+                return m_translations.at(idx);
+            return m_pooled.at(idx);
+        }
+
+        [[nodiscard]] inline const DxPtr<const DxDefinitionTable>& definitionTable() const
+        { return m_definitionTable; }
+    };
+
+    /**
+     * Where a language is published: the default language of a `DxData`, or one of its resident languages. Publishing
+     * replaces the language as a whole, and its id is published along with it so that readers can cheaply tell that
+     * the language they hold is out of date.
+     */
+    class DxLanguageSlot
+    {
+        std::mutex m_publishing{};
+        std::atomic<DxPtr<const DxLanguage>> m_current{};
+        std::atomic<int> m_id{ -1 };
+
+    public:
+        [[nodiscard]] inline DxPtr<const DxLanguage> current() const
+        { return m_current.load(std::memory_order_acquire); }
+
+        [[nodiscard]] inline bool isCurrent(const DxLanguage& language) const
+        { return language.id() == m_id.load(std::memory_order_acquire); }
+
+        [[nodiscard]] inline int id() const
+        { return m_id.load(std::memory_order_acquire); }
+
+        void publish(DxPtr<const DxLanguage> language)
+        {
+            // Only so that the id always ends up matching the language when two get published at once
+            std::lock_guard lock(m_publishing);
+            auto id = language->id();
+            m_current.store(std::move(language), std::memory_order_release);
+            m_id.store(id, std::memory_order_release);
+        }
+    };
+}
+
+#endif //LIBDIANNEX_DXLANGUAGE_HPP
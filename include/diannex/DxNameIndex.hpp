@@ -0,0 +1,82 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXNAMEINDEX_HPP
+#define LIBDIANNEX_DXNAMEINDEX_HPP
+
+#include "common.hpp"
+
+namespace diannex
+{
+    /**
+     * Minimal perfect hash of the scene, function or definition names of a binary, from each name to its index.
+     * Written by the compiler into the name index section and used where it is, so nothing is built at load; a lookup
+     * is one hash of the name and two reads. Names that aren't in the table still lead to some index, so callers
+     * compare the name found there.
+     *
+     * A table is a `uint32_t` count n, then n `int32_t` bucket seeds, then n `uint32_t` indices. A name's bucket
+     * comes from its hash, and the bucket's seed gives its slot: from the hash mixed with that seed for buckets of
+     * several names, or `-(slot + 1)` for buckets of one. See `bucket` and `slot`. Tables are read unaligned, as sections are only aligned
+     * relative to the payload.
+     */
+    class DxNameIndex
+    {
+        const std::byte* m_table{ nullptr };
+        uint32_t m_size{ 0 };
+
+    public:
+        [[nodiscard]] inline bool empty() const
+        { return m_size == 0; }
+
+        [[nodiscard]] inline size_t size() const
+        { return m_size; }
+
+        /** Where `name` would be. Callers check that the index is in range and that the name there matches. */
+        [[nodiscard]] DxOpt<uint32_t> find(const DxStrRef& name) const;
+
+        [[nodiscard]] static uint64_t hash(const DxStrRef& name);
+
+        /** The MurmurHash3 finalizer. */
+        [[nodiscard]] static inline uint64_t fmix(uint64_t hash)
+        {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDu;
+            hash ^= hash >> 33;
+            hash *= 0xC4CEB9FE1A85EC53u;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        /** Bucket of a name with hash `hash`, in a table of `size` names. */
+        [[nodiscard]] static inline uint32_t bucket(uint64_t hash, uint32_t size)
+        { return (uint32_t)(((hash & 0xFFFFFFFFu) * size) >> 32); }
+
+        /**
+         * Slot of a name with hash `hash` in a bucket with seed `seed`, in a table of `size` names. Nearby seeds give
+         * unrelated slots without hashing the name again.
+         */
+        [[nodiscard]] static inline uint32_t slot(uint64_t hash, uint32_t seed, uint32_t size)
+        { return (uint32_t)(((fmix(hash ^ (seed * 0x9E3779B97F4A7C15u)) >> 32) * size) >> 32); }
+
+        /** The table at the start of `bytes`, which is moved past it. */
+        [[nodiscard]] static DxNameIndex view(DxByteSpan& bytes);
+
+        /** Appends a table of `names`, each mapped to its position in it, to `out`. */
+        static void build(DxROSpan<DxStrRef> names, DxByteBuf& out);
+    };
+}
+
+#endif //LIBDIANNEX_DXNAMEINDEX_HPP
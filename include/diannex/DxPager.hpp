@@ -0,0 +1,95 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXPAGER_HPP
+#define LIBDIANNEX_DXPAGER_HPP
+
+#include "common.hpp"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+
+namespace diannex
+{
+    // Forward Declaration
+    class DxMappedFile;
+
+    /**
+     * Keeps recently used chunks of a mapped binary resident within a memory budget, a chunk being the code of a scene
+     * or function along with the text it uses. Touching a chunk pages it in (asks for it to be read ahead) and marks it
+     * most recently used; once the resident chunks add up to more than the budget, the least recently used are released
+     * until they fit again. Released pages stay mapped, so anything still using them just reads them back in.
+     *
+     * Safe to touch from several threads at once.
+     */
+    class DxPager
+    {
+    public:
+        using Chunk = uint32_t;
+
+        DxPager(DxPtr<const DxMappedFile> file, size_t chunkCount, size_t budget);
+
+        [[nodiscard]] size_t budget() const;
+
+        void budget(size_t bytes);
+
+        [[nodiscard]] size_t residentBytes() const;
+
+        [[nodiscard]] size_t residentChunks() const;
+
+        /** Marks `chunk` as most recently used, paging in the memory `ranges` returns (only asked the first time). */
+        template<class Ranges>
+        void touch(Chunk chunk, Ranges&& ranges)
+        {
+            // Scenes usually run for a while, and functions get called in loops, so this is the common case
+            if (m_mostRecent.load(std::memory_order_relaxed) == chunk)
+                return;
+
+            std::lock_guard lock(m_mutex);
+            if (!m_chunks[chunk].known)
+            {
+                m_chunks[chunk].ranges = ranges();
+                m_chunks[chunk].known = true;
+            }
+            touchLocked(chunk);
+        }
+
+    private:
+        struct ChunkState
+        {
+            DxVec<DxByteSpan> ranges{};
+            size_t size{ 0 };
+            bool known{ false };
+            bool resident{ false };
+            std::list<Chunk>::iterator position{};
+        };
+
+        DxPtr<const DxMappedFile> m_file;
+        size_t m_budget;
+        size_t m_residentBytes{ 0 };
+        DxVec<ChunkState> m_chunks;
+        std::list<Chunk> m_recent{};
+        std::atomic<Chunk> m_mostRecent{ UINT32_MAX };
+        mutable std::mutex m_mutex{};
+
+        void touchLocked(Chunk chunk);
+
+        void evictLocked();
+    };
+}
+
+#endif //LIBDIANNEX_DXPAGER_HPP
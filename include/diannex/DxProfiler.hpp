@@ -0,0 +1,187 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXPROFILER_HPP
+#define LIBDIANNEX_DXPROFILER_HPP
+
+#include "common.hpp"
+#include "DxInstructions.hpp"
+
+#include <array>
+#include <chrono>
+
+namespace diannex
+{
+    /**
+     * Opt-in interpreter profiler, only compiled in when the library is configured with `ENABLE_PROFILER`
+     * (which defines `DIANNEX_PROFILER`). Without it, none of this is referenced and the `DX_PROFILE_*` hooks in the
+     * interpreter expand to nothing.
+     *
+     * When compiled in, it still has to be switched on at runtime through `DxInterpreter::profiler().enable()`; while
+     * switched off it costs one branch per instruction. Every instruction is timed individually while enabled, which
+     * made the sample scene about 40% slower in `libdnxpp_bench` (build with `BUILD_BENCHMARKS` to measure it).
+     */
+    class DxProfiler
+    {
+        using Clock = std::chrono::steady_clock;
+
+    public:
+        struct OpcodeStats
+        {
+            uint64_t count{};
+            uint64_t nanoseconds{};
+        };
+
+        struct FrameStats
+        {
+            DxStr name{};
+            bool isScene{};
+            uint64_t calls{};
+            uint64_t inclusiveNanoseconds{};
+            uint64_t exclusiveNanoseconds{};
+        };
+
+        struct NativeStats
+        {
+            uint64_t calls{};
+            uint64_t nanoseconds{};
+        };
+
+        class InstructionScope
+        {
+            DxProfiler* m_profiler;
+            int m_programCounter;
+            DxOpcode m_opcode;
+            Clock::time_point m_start;
+        public:
+            InstructionScope(DxProfiler* profiler, int programCounter, DxOpcode opcode)
+                : m_profiler(profiler), m_programCounter(programCounter), m_opcode(opcode),
+                  m_start(profiler ? Clock::now() : Clock::time_point{})
+            {}
+
+            InstructionScope(const InstructionScope&) = delete;
+
+            ~InstructionScope()
+            {
+                if (m_profiler)
+                    m_profiler->recordInstruction(m_programCounter, m_opcode, Clock::now() - m_start);
+            }
+        };
+
+        class NativeScope
+        {
+            DxProfiler* m_profiler;
+            DxStrRef m_name;
+            Clock::time_point m_start;
+        public:
+            NativeScope(DxProfiler* profiler, DxStrRef name)
+                : m_profiler(profiler), m_name(name), m_start(profiler ? Clock::now() : Clock::time_point{})
+            {}
+
+            NativeScope(const NativeScope&) = delete;
+
+            ~NativeScope()
+            {
+                if (m_profiler)
+                    m_profiler->recordNative(m_name, Clock::now() - m_start);
+            }
+        };
+
+        void enable(bool enabled = true)
+        { m_enabled = enabled; }
+
+        [[nodiscard]] bool enabled() const
+        { return m_enabled; }
+
+        void reset();
+
+        [[nodiscard]] InstructionScope instruction(int programCounter, DxOpcode opcode)
+        { return { m_enabled ? this : nullptr, programCounter, opcode }; }
+
+        [[nodiscard]] NativeScope native(DxStrRef name)
+        { return { m_enabled ? this : nullptr, name }; }
+
+        void enterFrame(DxStrRef name, bool isScene);
+
+        void leaveFrame();
+
+        void leaveAllFrames();
+
+        [[nodiscard]] const std::array<OpcodeStats, 256>& opcodes() const
+        { return m_opcodes; }
+
+        [[nodiscard]] const DxVec<FrameStats>& frames() const
+        { return m_frames; }
+
+        [[nodiscard]] const DxMap<DxStr, NativeStats>& natives() const
+        { return m_natives; }
+
+        [[nodiscard]] const DxMap<int, uint64_t>& programCounters() const
+        { return m_programCounters; }
+
+        [[nodiscard]] DxStr toJson() const;
+
+        /**
+         * Exclusive time per call stack in the "collapsed stack" format read by flamegraph.pl and speedscope,
+         * one `scene;function;function <nanoseconds>` line per distinct stack.
+         */
+        [[nodiscard]] DxStr toCollapsedStacks() const;
+
+    private:
+        struct ActiveFrame
+        {
+            size_t frame;
+            size_t path;
+            uint64_t inclusiveNanoseconds;
+        };
+
+        struct StackPath
+        {
+            DxStr name;
+            uint64_t nanoseconds;
+        };
+
+        bool m_enabled{ false };
+        std::array<OpcodeStats, 256> m_opcodes{};
+        DxVec<FrameStats> m_frames{};
+        DxMap<DxStr, size_t> m_frameIndices{};
+        DxVec<StackPath> m_paths{};
+        DxMap<DxStr, size_t> m_pathIndices{};
+        DxMap<DxStr, NativeStats> m_natives{};
+        DxMap<int, uint64_t> m_programCounters{};
+        DxVec<ActiveFrame> m_activeFrames{};
+
+        void recordInstruction(int programCounter, DxOpcode opcode, Clock::duration elapsed);
+
+        void recordNative(DxStrRef name, Clock::duration elapsed);
+    };
+}
+
+#ifdef DIANNEX_PROFILER
+#define DX_PROFILE_INSTRUCTION(profiler, pc, opcode) auto _dxInstructionScope = (profiler).instruction(pc, opcode)
+#define DX_PROFILE_NATIVE(profiler, name) auto _dxNativeScope = (profiler).native(name)
+#define DX_PROFILE_ENTER(profiler, name, isScene) do { if ((profiler).enabled()) (profiler).enterFrame(name, isScene); } while (0)
+#define DX_PROFILE_LEAVE(profiler) do { if ((profiler).enabled()) (profiler).leaveFrame(); } while (0)
+#define DX_PROFILE_LEAVE_ALL(profiler) (profiler).leaveAllFrames()
+#else
+#define DX_PROFILE_INSTRUCTION(profiler, pc, opcode)
+#define DX_PROFILE_NATIVE(profiler, name)
+#define DX_PROFILE_ENTER(profiler, name, isScene) do {} while (0)
+#define DX_PROFILE_LEAVE(profiler) do {} while (0)
+#define DX_PROFILE_LEAVE_ALL(profiler) do {} while (0)
+#endif
+
+#endif //LIBDIANNEX_DXPROFILER_HPP
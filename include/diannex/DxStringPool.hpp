@@ -0,0 +1,73 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXSTRINGPOOL_HPP
+#define LIBDIANNEX_DXSTRINGPOOL_HPP
+
+#include "common.hpp"
+
+namespace diannex
+{
+    /**
+     * Null-terminated strings shared by several languages, each distinct string stored once. Strings never move once
+     * pooled, so languages refer to them by pointer and keep the pool alive for as long as they do.
+     *
+     * New strings are copied into chunks of their own; strings that are already in memory elsewhere (like the text of
+     * the binary) can be adopted where they are instead. Adding strings isn't thread safe, reading pooled ones is.
+     */
+    class DxStringPool
+    {
+        static constexpr size_t ChunkSize = 1024 * 1024;
+
+        DxVec<std::unique_ptr<char[]>> m_chunks{};
+        char* m_chunkNext{ nullptr };
+        size_t m_chunkFree{ 0 };
+        DxVec<DxPtr<const void>> m_storage{};
+        DxVec<const char*> m_slots{};
+        size_t m_size{ 0 };
+        size_t m_bytes{ 0 };
+
+    public:
+        /** The pooled copy of `str`, which is copied in first if it isn't pooled yet. */
+        const char* intern(DxStrRef str);
+
+        /**
+         * Like `intern`, but pools `str` where it is rather than copying it. It has to be null-terminated, and stay
+         * valid for as long as the pool does (see `keep`).
+         */
+        const char* adopt(DxStrRef str);
+
+        /** Keeps `storage` alive for as long as the pool, for strings adopted from it. */
+        void keep(DxPtr<const void> storage);
+
+        /** Number of distinct strings. */
+        [[nodiscard]] inline size_t size() const
+        { return m_size; }
+
+        /** Bytes of text copied into the pool, terminators included. */
+        [[nodiscard]] inline size_t bytes() const
+        { return m_bytes; }
+
+    private:
+        const char*& slot(DxStrRef str);
+
+        const char* store(DxStrRef str);
+
+        void rehash(size_t slotCount);
+    };
+}
+
+#endif //LIBDIANNEX_DXSTRINGPOOL_HPP
@@ -0,0 +1,75 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXSTRINGTABLE_HPP
+#define LIBDIANNEX_DXSTRINGTABLE_HPP
+
+#include "common.hpp"
+
+namespace diannex
+{
+    /**
+     * Null-terminated strings stored back to back in one arena, as in the string blocks of a binary, indexed by where
+     * each of them starts. The length of a string follows from where the next one starts, so the index is one
+     * `uint32_t` per string, and every lookup is a view into the arena. The arena itself is owned by someone else.
+     */
+    class DxStringTable
+    {
+        const char* m_arena{ nullptr };
+        size_t m_arenaSize{ 0 };
+        DxVec<uint32_t> m_offsets{ 0 };
+        // Used instead of m_offsets by tables made `inPlace`
+        DxROSpan<uint32_t> m_index{};
+
+        [[nodiscard]] inline DxROSpan<uint32_t> offsets() const
+        { return m_index.empty() ? DxROSpan<uint32_t>{ m_offsets } : m_index; }
+
+    public:
+        DxStringTable() = default;
+
+        /** Indexes the first `count` strings of `arena`, throwing if it ends before all of them are terminated. */
+        DxStringTable(DxByteSpan arena, size_t count);
+
+        /**
+         * Takes the index from `ends` instead, where each string ends (past its terminator) as an offset into `arena`,
+         * so the arena itself isn't read at all.
+         */
+        DxStringTable(DxByteSpan arena, DxROSpan<uint32_t> ends);
+
+        /**
+         * Uses `offsets` (where each string starts, then where the last one ends) where it is, without reading it or
+         * the arena up front, so this is O(1) whatever the size. `at` checks each string when it's looked up instead;
+         * `operator[]` doesn't, so it's only for indexes known to be valid. Both have to outlive the table.
+         */
+        [[nodiscard]] static DxStringTable inPlace(DxByteSpan arena, DxROSpan<uint32_t> offsets);
+
+        [[nodiscard]] inline size_t size() const
+        { return offsets().size() - 1; }
+
+        [[nodiscard]] inline bool empty() const
+        { return size() == 0; }
+
+        [[nodiscard]] inline DxStrRef operator[](size_t idx) const
+        {
+            auto offsets = this->offsets();
+            return { m_arena + offsets[idx], offsets[idx + 1] - offsets[idx] - 1 };
+        }
+
+        [[nodiscard]] DxStrRef at(size_t idx) const;
+    };
+}
+
+#endif //LIBDIANNEX_DXSTRINGTABLE_HPP
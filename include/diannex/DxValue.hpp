@@ -75,9 +75,14 @@ namespace diannex
 
     class DxValue
     {
-        using array_type = DxVec<DxPtr<DxValue>>;
+    public:
+        /** Strings and arrays keep the memory resource they were allocated from, see `copy` */
+        using string_type = DxPmrStr;
+        using array_type = DxPmrVec<DxPtr<DxValue>>;
+
+    private:
         using variant_type = DxVariant<
-            int, double, DxStr,
+            int, double, string_type,
             array_type, DxAny>;
         using value_type = DxOpt<variant_type>;
 
@@ -89,6 +94,11 @@ namespace diannex
 
         explicit DxValue(bool value);
 
+        explicit DxValue(const DxStr& value, DxValueType type = DxValueType::String);
+
+        /** A string allocated from `resource`. */
+        DxValue(DxStrRef value, DxMemoryResource* resource);
+
         DxValue(DxValue&& other) noexcept
             : m_value(std::move(other.m_value)),
               m_type(std::exchange(other.m_type, DxValueType::Unknown))
@@ -107,6 +117,12 @@ namespace diannex
 
         [[nodiscard]] DxValue convert(DxValueType newType) const;
 
+        /**
+         * Copies the value with its string, or its array and everything in it, allocated from `resource`. Plain copies
+         * of a string or array go on the default resource, but share the values in an array with the original.
+         */
+        [[nodiscard]] DxValue copy(DxMemoryResource* resource) const;
+
         [[nodiscard]] inline DxValueType type() const
         { return m_type; }
 
@@ -130,7 +146,7 @@ namespace diannex
             else if constexpr (type == DxValueType::Double)
                 return this->convert(type).get<double>();
             else if constexpr (type == DxValueType::String)
-                return this->convert(type).get<DxStr>();
+                return DxStr{ m_type == type ? get<string_type>() : this->convert(type).get<string_type>() };
             else
                 static_assert(type != DxValueType::Integer &&
                               type != DxValueType::Double &&
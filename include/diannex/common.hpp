@@ -24,11 +24,13 @@
 #include <variant>
 #include <any>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <sstream>
 #include <concepts>
 #include <functional>
+#include <utility>
 
 #ifndef USE_FMTLIB
 #include <format>
@@ -41,6 +43,9 @@ namespace diannex
     template<typename T>
     using DxVec = std::vector<T>;
     using DxByteBuf = DxVec<std::byte>;
+    template<typename T>
+    using DxPmrVec = std::pmr::vector<T>;
+    using DxMemoryResource = std::pmr::memory_resource;
     template<typename TKey, typename TVal>
     using DxMap = std::unordered_map<TKey, TVal>;
 
@@ -64,6 +69,7 @@ namespace diannex
     using DxWeakPtr = std::weak_ptr<T>;
 
     using DxStr = std::string;
+    using DxPmrStr = std::pmr::string;
     using DxStrRef = std::string_view;
     using DxStrBuilder = std::stringstream;
 
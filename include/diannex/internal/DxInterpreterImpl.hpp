@@ -0,0 +1,750 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXINTERPRETERIMPL_HPP
+#define LIBDIANNEX_DXINTERPRETERIMPL_HPP
+
+#include "../DxInterpreter.hpp"
+#include "../DxInstructions.hpp"
+#include "../utils/BinaryReader.hpp"
+
+#include <cmath>
+
+// The interpreter loop, templated over its instrumentation policy. Included at the end of DxInterpreter.hpp so that
+// custom policies can be instantiated outside of the library.
+namespace diannex
+{
+    template<DxInstrumentationPolicy Policy>
+    void DxInterpreter::runScene(const DxStrRef& name)
+    {
+        runScene<Policy>(sceneId(name));
+    }
+
+    template<DxInstrumentationPolicy Policy>
+    void DxInterpreter::runScene(DxSceneId scene)
+    {
+        if (!enterScene(scene))
+            return;
+
+        auto buff = m_data->instructions();
+        while (m_state == State::Running)
+        {
+            interpret<Policy>(buff.subspan(m_programCounter));
+        }
+    }
+
+    template<DxInstrumentationPolicy Policy>
+    void DxInterpreter::resumeScene()
+    {
+        if (m_state == State::Paused || m_state == State::InText || m_state == State::Suspended)
+            m_state = State::Running;
+
+        auto buff = m_data->instructions();
+        while (m_state == State::Running)
+            interpret<Policy>(buff.subspan(m_programCounter));
+    }
+
+    template<DxInstrumentationPolicy Policy>
+    DxInterpreter::State DxInterpreter::step(size_t maxInstructions)
+    {
+        if (m_state == State::Paused || m_state == State::InText || m_state == State::Suspended)
+            m_state = State::Running;
+
+        auto buff = m_data->instructions();
+        for (size_t i = 0; i < maxInstructions && m_state == State::Running; ++i)
+            interpret<Policy>(buff.subspan(m_programCounter));
+
+        if (m_state == State::Running)
+            m_state = State::Suspended;
+        return m_state;
+    }
+
+    template<DxInstrumentationPolicy Policy>
+    DxInterpreter::State DxInterpreter::runFor(std::chrono::steady_clock::time_point deadline)
+    {
+        while (step<Policy>(DeadlineCheckInterval) == State::Suspended)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+                break;
+        }
+        return m_state;
+    }
+
+    template<DxInstrumentationPolicy Policy>
+    void DxInterpreter::selectChoice(int idx)
+    {
+        assert_state(State::InChoice, "Attempting to select choice in invalid state");
+
+        m_programCounter = m_choiceOptions[idx].targetOffset;
+        m_choiceOptions.clear();
+
+        m_state = State::Running;
+        auto buff = m_data->instructions();
+        while (m_state == State::Running)
+            interpret<Policy>(buff.subspan(m_programCounter));
+    }
+
+    template<DxInstrumentationPolicy Policy>
+    void DxInterpreter::executeEvalMultiple(int address)
+    {
+        assert_state(State::Inactive,
+                     "Invalid execution state in interpreter - make a separate interpreter?");
+
+        m_state = State::Eval;
+        m_programCounter = address;
+
+        auto buff = m_data->instructions();
+        while (m_state == State::Eval)
+            interpret<Policy>(buff.subspan(m_programCounter));
+    }
+
+    template<DxInstrumentationPolicy Policy>
+    void DxInterpreter::interpret(DxByteSpan buff)
+    {
+        auto reader = BinarySpanReader::create(buff);
+        auto read = [this, &reader]<typename T>
+        {
+            m_programCounter += sizeof(T);
+            return reader->read<T>();
+        };
+        auto argI = [&read]
+        { return std::tuple(read.template operator()<int32_t>()); };
+        auto argII = [&read]
+        {
+            auto v1 = read.template operator()<int32_t>();
+            auto v2 = read.template operator()<int32_t>();
+            return std::tuple(v1, v2);
+        };
+        auto argD = [&read]
+        { return std::tuple(read.template operator()<double>()); };
+
+        auto opcode = read.template operator()<DxOpcode>();
+        DX_PROFILE_INSTRUCTION(m_profiler, m_programCounter - (int)sizeof(DxOpcode), opcode);
+        Policy::onInstruction(*this, m_programCounter - (int)sizeof(DxOpcode), opcode);
+        switch (opcode)
+        {
+            case DxOpcode::nop:
+                break;
+            case DxOpcode::freeloc:
+            {
+                auto [argIndex] = argI();
+                if ((size_t)argIndex == m_locals.get().size() - 1)
+                {
+                    if (argIndex < m_flagCount)
+                    {
+                        auto names = m_currentFunction
+                                     ? m_functionFlags.get().names(m_data->functionTable(), *m_currentFunction)
+                                     : m_sceneFlags.get().names(m_data->sceneTable(), *m_currentScene);
+                        m_setFlagHandler(names[argIndex], exported(std::move(m_locals.mut()[argIndex])));
+                    }
+
+                    m_locals->pop_back();
+                }
+                break;
+            }
+
+            case DxOpcode::save:
+            {
+                m_saveRegister = scoped(m_stack->peek());
+                break;
+            }
+
+            case DxOpcode::load:
+            {
+                m_stack->push(std::move(m_saveRegister).value_or(DxValue{}));
+                m_saveRegister.reset();
+                break;
+            }
+
+            case DxOpcode::pushu:
+            {
+                m_stack->push(DxValue{});
+                break;
+            }
+
+            case DxOpcode::pushi:
+            {
+                auto [val] = argI();
+                m_stack->push(DxValue{ val, DxValueType::Integer });
+                break;
+            }
+
+            case DxOpcode::pushd:
+            {
+                auto [val] = argD();
+                m_stack->push(DxValue{ val, DxValueType::Double });
+                break;
+            }
+
+            case DxOpcode::pushs:
+            case DxOpcode::pushbs:
+            {
+                auto [textIdx] = argI();
+                DxStrRef str;
+                if (opcode == DxOpcode::pushs)
+                {
+                    syncLanguage();
+                    str = m_language->translation(textIdx);
+                }
+                else
+                    str = m_data->string(textIdx);
+
+                m_stack->push(DxValue{ str, m_memoryResource });
+                break;
+            }
+
+            case DxOpcode::pushints:
+            case DxOpcode::pushbints:
+            {
+                auto [textIdx, elemCount] = argII();
+                DxStrRef str;
+                if (opcode == DxOpcode::pushints)
+                {
+                    syncLanguage();
+                    str = m_language->translation(textIdx);
+                }
+                else
+                    str = m_data->string(textIdx);
+
+                DxPmrVec<DxPmrStr> elems(elemCount, m_memoryResource);
+                for (int i = 0; i < elemCount; ++i)
+                {
+                    auto value = m_stack->pop();
+                    if (value.type() == DxValueType::String)
+                        elems[i] = std::move(value.get_mut<DxValue::string_type>());
+                    else
+                        elems[i] = value.convert(DxValueType::String).get<DxValue::string_type>();
+                }
+
+                m_stack->push(DxValue{ interpolate(str, elems, m_memoryResource), DxValueType::String });
+                break;
+            }
+
+            case DxOpcode::makearr:
+            {
+                auto [arrSize] = argI();
+                std::pmr::polymorphic_allocator<DxValue> allocator{ m_memoryResource };
+                DxValue::array_type arr(arrSize, m_memoryResource);
+                for (int i = arrSize - 1; i >= 0; i--)
+                    arr[i] = std::allocate_shared<DxValue>(allocator, m_stack->pop());
+                m_stack->push(DxValue{ std::move(arr), DxValueType::Array });
+                break;
+            }
+
+            case DxOpcode::pusharrind:
+            {
+                auto ind = m_stack->pop().safe_get<DxValueType::Integer>();
+                auto arr = std::move(m_stack->pop());
+                if (arr.type() != DxValueType::Array)
+                    panic("Array get on variable which is not an array");
+                const auto& vArr = arr.get<DxValue::array_type>();
+                m_stack->push(scoped(*(vArr[ind])));
+                break;
+            }
+
+            case DxOpcode::setarrind:
+            {
+                auto value = std::move(m_stack->pop());
+                auto ind = m_stack->pop().safe_get<DxValueType::Integer>();
+                auto& arr = m_stack->peek();
+                if (arr.type() != DxValueType::Array)
+                    panic("Array set on variable which is not an array");
+                auto& vArr = arr.get_mut<DxValue::array_type>();
+                std::pmr::polymorphic_allocator<DxValue> allocator{ vArr.get_allocator().resource() };
+                vArr[ind] = std::allocate_shared<DxValue>(allocator, value.copy(allocator.resource()));
+                break;
+            }
+
+            case DxOpcode::setvarglb:
+            {
+                auto [nameIdx] = argI();
+                auto name = m_data->string(nameIdx);
+                m_setVariableHandler(name, exported(m_stack->pop()));
+                break;
+            }
+
+            case DxOpcode::setvarloc:
+            {
+                auto&& value = m_stack->pop();
+                auto count = m_locals.get().size();
+
+                auto [idx] = argI();
+                if ((size_t)idx >= count)
+                {
+                    for (size_t i = 0; i < idx - count; ++i)
+                        m_locals->emplace_back();
+
+                    m_locals->push_back(std::move(value));
+                }
+                else
+                {
+                    m_locals.mut()[idx] = std::move(value);
+                }
+
+                break;
+            }
+
+            case DxOpcode::pushvarglb:
+            {
+                auto [nameIdx] = argI();
+                auto name = m_data->string(nameIdx);
+                m_stack->push(m_getVariableHandler(name));
+                break;
+            }
+
+            case DxOpcode::pushvarloc:
+            {
+                auto [idx] = argI();
+                if ((size_t)idx >= m_locals.get().size())
+                    m_stack->push(DxValue{});
+                else
+                    m_stack->push(scoped(m_locals.get()[idx]));
+                break;
+            }
+
+            case DxOpcode::pop:
+                (void)m_stack->pop();
+                break;
+
+            case DxOpcode::dup:
+                m_stack->push(scoped(m_stack->peek()));
+                break;
+
+            case DxOpcode::dup2:
+            {
+                auto v1 = m_stack->pop();
+                auto v2 = m_stack->pop();
+                m_stack->push(scoped(v2));
+                m_stack->push(scoped(v1));
+                m_stack->push(std::move(v2));
+                m_stack->push(std::move(v1));
+                break;
+            }
+
+            case DxOpcode::add:
+            case DxOpcode::sub:
+            case DxOpcode::mul:
+            case DxOpcode::div:
+            case DxOpcode::mod:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                switch (opcode)
+                {
+                    case DxOpcode::add:
+                        m_stack->push(v1 + v2);
+                        break;
+                    case DxOpcode::sub:
+                        m_stack->push(v1 - v2);
+                        break;
+                    case DxOpcode::mul:
+                        m_stack->push(v1 * v2);
+                        break;
+                    case DxOpcode::div:
+                        m_stack->push(v1 / v2);
+                        break;
+                    case DxOpcode::mod:
+                        m_stack->push(v1 % v2);
+                        break;
+                    default:; // To make IDE happy despite the fact this branch is will never be touched
+                }
+                break;
+            }
+
+            case DxOpcode::neg:
+            {
+                auto v = m_stack->pop();
+                auto t = v.type();
+                switch (t)
+                {
+                    case DxValueType::Integer:
+                        m_stack->push(DxValue{ -v.get<int>(), DxValueType::Integer });
+                        break;
+                    case DxValueType::Double:
+                        m_stack->push(DxValue{ -v.get<double>(), DxValueType::Double });
+                        break;
+                    default:
+                        panic(DxFormat("Cannot negate type {}", type_name(t)));
+                }
+                break;
+            }
+
+            case DxOpcode::inv:
+            {
+                auto v = m_stack->pop();
+                auto t = v.type();
+                switch (t)
+                {
+                    case DxValueType::Integer:
+                        m_stack->push(DxValue{ !v.get<int>() ? 1 : 0, DxValueType::Integer });
+                        break;
+                    case DxValueType::Double:
+                        m_stack->push(DxValue{ !(bool)(v.get<double>()) ? 1.0 : 0.0, DxValueType::Double });
+                        break;
+                    default:
+                        panic(DxFormat("Cannot invert type {}", type_name(t)));
+                }
+                break;
+            }
+
+            case DxOpcode::bitls:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(DxValue{ v1.safe_get<DxValueType::Integer>() << v2.safe_get<DxValueType::Integer>(),
+                                      DxValueType::Integer });
+                break;
+            }
+
+            case DxOpcode::bitrs:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(DxValue{ v1.safe_get<DxValueType::Integer>() >> v2.safe_get<DxValueType::Integer>(),
+                                      DxValueType::Integer });
+                break;
+            }
+
+            case DxOpcode::_bitand:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(DxValue{ v1.safe_get<DxValueType::Integer>() & v2.safe_get<DxValueType::Integer>(),
+                                      DxValueType::Integer });
+                break;
+            }
+
+            case DxOpcode::_bitor:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(DxValue{ v1.safe_get<DxValueType::Integer>() | v2.safe_get<DxValueType::Integer>(),
+                                      DxValueType::Integer });
+                break;
+            }
+
+            case DxOpcode::bitxor:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(DxValue{ v1.safe_get<DxValueType::Integer>() ^ v2.safe_get<DxValueType::Integer>(),
+                                      DxValueType::Integer });
+                break;
+            }
+
+            case DxOpcode::bitneg:
+                m_stack->push(DxValue{ ~m_stack->pop().safe_get<DxValueType::Integer>(), DxValueType::Integer });
+                break;
+
+            case DxOpcode::pow:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(DxValue{
+                    std::pow(
+                        v1.safe_get<DxValueType::Double>(),
+                        v2.safe_get<DxValueType::Double>()),
+                    DxValueType::Integer });
+                break;
+            }
+
+            case DxOpcode::cmpeq:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(v1 == v2);
+                break;
+            }
+
+            case DxOpcode::cmpgt:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(v1 > v2);
+                break;
+            }
+
+            case DxOpcode::cmplt:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(v1 < v2);
+                break;
+            }
+
+            case DxOpcode::cmpgte:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(v1 >= v2);
+                break;
+            }
+
+            case DxOpcode::cmplte:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(v1 <= v2);
+                break;
+            }
+
+            case DxOpcode::cmpneq:
+            {
+                auto v2 = m_stack->pop();
+                auto v1 = m_stack->pop();
+                m_stack->push(v1 != v2);
+                break;
+            }
+
+            case DxOpcode::j:
+            {
+                auto [relAddr] = argI();
+                m_programCounter += relAddr;
+                break;
+            }
+
+            case DxOpcode::jt:
+            {
+                auto [relAddr] = argI();
+                if (m_stack->pop().safe_get<DxValueType::Integer>() != 0)
+                    m_programCounter += relAddr;
+                break;
+            }
+
+            case DxOpcode::jf:
+            {
+                auto [relAddr] = argI();
+                if (m_stack->pop().safe_get<DxValueType::Integer>() == 0)
+                    m_programCounter += relAddr;
+                break;
+            }
+
+            case DxOpcode::exit:
+            {
+                if (m_state == State::Eval)
+                {
+                    m_state = State::Inactive;
+                    break;
+                }
+
+                if (m_callStack.get().empty())
+                {
+                    endScene();
+                    break;
+                }
+
+                DX_PROFILE_LEAVE(m_profiler);
+                Policy::onReturn(*this);
+                auto lastFrame = m_callStack->pop();
+                m_programCounter = lastFrame.returnOffset;
+                m_stack = std::move(lastFrame.stack);
+                m_locals = std::move(lastFrame.locals);
+                m_flagCount = lastFrame.flagCount;
+                m_currentFunction = lastFrame.function;
+
+                m_stack->push(DxValue{});
+
+                break;
+            }
+
+            case DxOpcode::ret:
+            {
+                if (m_callStack.get().empty())
+                {
+                    endScene();
+                    break;
+                }
+
+                DX_PROFILE_LEAVE(m_profiler);
+                Policy::onReturn(*this);
+                auto returnValue = m_stack->pop();
+                auto lastFrame = m_callStack->pop();
+                m_stack = std::move(lastFrame.stack);
+                m_locals = std::move(lastFrame.locals);
+                m_flagCount = lastFrame.flagCount;
+                m_currentFunction = lastFrame.function;
+
+                m_stack->push(std::move(returnValue));
+                break;
+            }
+
+            case DxOpcode::call:
+            {
+                auto [funcIdx, count] = argII();
+
+                DxPmrVec<DxValue> args(count, m_memoryResource);
+                for (int i = 0; i < count; ++i)
+                    args[i] = std::move(m_stack->pop());
+
+                m_callStack->push({
+                                     .returnOffset = m_programCounter,
+                                     .stack = std::exchange(m_stack, makeStack()),
+                                     .locals = std::exchange(m_locals, makeLocals()),
+                                     .flagCount = m_flagCount,
+                                     .function = m_currentFunction
+                                 });
+                const auto& functions = m_data->functionTable();
+                auto func = (DxFunctionId)funcIdx;
+                m_data->pageIn(func);
+                if (!m_functionFlags.get().ready(func))
+                    prepareFlags(functions, m_functionFlags.mut(), func);
+                m_programCounter = functions.codeOffset(func);
+                DX_PROFILE_ENTER(m_profiler, functions.name(func), false);
+
+                auto flagNames = m_functionFlags.get().names(functions, func);
+                m_currentFunction = func;
+                m_flagCount = (int)flagNames.size();
+                for (int i = 0; i < m_flagCount; ++i)
+                    m_locals->push_back(std::move(m_getFlagHandler(flagNames[i])));
+
+                for (int i = 0; i < count; ++i)
+                    m_locals->push_back(std::move(args[i]));
+
+                Policy::onCall(*this, functions.name(func));
+                break;
+            }
+
+            case DxOpcode::callext:
+            {
+                auto [funcNameIdx, argCount] = argII();
+                auto funcName = m_data->string(funcNameIdx);
+
+                // Handed to the handler, so on the global heap
+                DxVec<DxValue> args(argCount);
+                for (int i = 0; i < argCount; ++i)
+                    args[i] = exported(m_stack->pop());
+
+                const auto& handlers = m_functionHandlers.get();
+                auto handler = handlers.contains(funcName)
+                               ? handlers.at(funcName)
+                               : ([this, funcName](auto& args) -> DxValue
+                    {
+                        m_unregisteredFunctionHandler(funcName);
+                        return DxValue{};
+                    });
+                Policy::onCallExt(*this, funcName, args);
+                DX_PROFILE_NATIVE(m_profiler, funcName);
+                m_stack->push(handler(args));
+                break;
+            }
+
+            case DxOpcode::choicebeg:
+            {
+                dx_assert(m_state == State::Running && !m_startingChoice, "Invalid choice begin state");
+
+                m_startingChoice = true;
+                break;
+            }
+
+            case DxOpcode::choiceadd:
+            {
+                dx_assert(m_startingChoice, "Invalid choice add state");
+                auto [rel] = argI();
+
+                auto chance = m_stack->pop().safe_get<DxValueType::Double>();
+                auto text = m_stack->pop().safe_get<DxValueType::String>();
+                if (m_chanceHandler(chance))
+                    m_choiceOptions.emplace_back(m_programCounter + rel, text);
+                break;
+            }
+
+            case DxOpcode::choiceaddt:
+            {
+                dx_assert(m_startingChoice, "Invalid choice add state");
+                auto [rel] = argI();
+
+                auto condition = m_stack->pop().safe_get<DxValueType::Integer>() != 0;
+                auto chance = m_stack->pop().safe_get<DxValueType::Double>();
+                auto text = m_stack->pop().safe_get<DxValueType::String>();
+                if (condition && m_chanceHandler(chance))
+                    m_choiceOptions.emplace_back(m_programCounter + rel, text);
+                break;
+            }
+
+            case DxOpcode::choicesel:
+            {
+                dx_assert(m_startingChoice, "Invalid choice selection state");
+                dx_assert(!m_choiceOptions.empty(), "Choice statement has no choices to present");
+
+                m_startingChoice = false;
+                m_state = State::InChoice;
+
+                auto count = m_choiceOptions.size();
+                DxVec<DxStr> textChoices(count);
+                for (size_t i = 0; i < count; ++i)
+                    textChoices[i] = m_choiceOptions[i].text;
+                m_choiceHandler(std::move(textChoices));
+                break;
+            }
+
+            case DxOpcode::chooseadd:
+            {
+                auto [rel] = argI();
+                m_chooseOptions.emplace_back(m_programCounter + rel, m_stack->pop().safe_get<DxValueType::Double>());
+                break;
+            }
+
+            case DxOpcode::chooseaddt:
+            {
+                auto [rel] = argI();
+                auto condition = m_stack->pop().safe_get<DxValueType::Integer>() != 0;
+                auto chance = m_stack->pop().safe_get<DxValueType::Double>();
+                if (condition != 0)
+                    m_chooseOptions.emplace_back(m_programCounter + rel, chance);
+                break;
+            }
+
+            case DxOpcode::choosesel:
+            {
+                dx_assert(!m_chooseOptions.empty(), "No entries for choose statement");
+
+                auto count = m_chooseOptions.size();
+                DxVec<double> weights(count);
+                for (size_t i = 0; i < count; ++i)
+                    weights[i] = m_chooseOptions[i].chance;
+
+                m_programCounter = m_chooseOptions[m_weighedChanceHandler(weights)].targetOffset;
+                m_chooseOptions.clear();
+                break;
+            }
+
+            case DxOpcode::textrun:
+            {
+                assert_state(State::Running, "Invalid text run state");
+
+                m_state = State::InText;
+                auto text = m_stack->pop().safe_get<DxValueType::String>();
+                Policy::onText(*this, text);
+                m_textHandler(std::move(text));
+                break;
+            }
+        }
+    }
+
+    // Instantiated once in the library, see src/DxInterpreterImpl.cpp
+    extern template void DxInterpreter::interpret<DxNoInstrumentation>(DxByteSpan);
+    extern template void DxInterpreter::runScene<DxNoInstrumentation>(const DxStrRef&);
+    extern template void DxInterpreter::runScene<DxNoInstrumentation>(DxSceneId);
+    extern template void DxInterpreter::resumeScene<DxNoInstrumentation>();
+    extern template DxInterpreter::State DxInterpreter::step<DxNoInstrumentation>(size_t);
+    extern template DxInterpreter::State
+    DxInterpreter::runFor<DxNoInstrumentation>(std::chrono::steady_clock::time_point);
+    extern template void DxInterpreter::selectChoice<DxNoInstrumentation>(int);
+    extern template void DxInterpreter::executeEvalMultiple<DxNoInstrumentation>(int);
+    extern template void DxInterpreter::executeEvalMultiple<DxInterpreter::DependencyTracker>(int);
+}
+
+#endif //LIBDIANNEX_DXINTERPRETERIMPL_HPP
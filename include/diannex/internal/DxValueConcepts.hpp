@@ -91,10 +91,15 @@ namespace diannex
     }
 
     template<std::constructible_from<DxStr> T>
-    inline auto coerce_from_value(const DxValue& value) -> T
-    {
-        return (T)
-            value.get<std::string>();
+    inline auto coerce_from_value(const DxValue& value) -> std::remove_cvref_t<T>
+    {
+        // By value, as the string held by the value is a different type than e.g. a `const std::string&` asked for
+        using U = std::remove_cvref_t<T>;
+        const auto& str = value.get<DxValue::string_type>();
+        if constexpr (std::constructible_from<U, const DxValue::string_type&>)
+            return U(str);
+        else
+            return U(DxStr{ str });
     }
 
     template<DxCopyCoercable T>
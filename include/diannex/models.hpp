@@ -17,6 +17,7 @@
 #ifndef LIBDIANNEX_MODELS_HPP
 #define LIBDIANNEX_MODELS_HPP
 
+#include <cstdint>
 #include <string_view>
 #include <string>
 #include <utility>
@@ -35,34 +36,45 @@ namespace diannex
         {}
     };
 
-    struct DxFunction
-    {
-        // Will be used in a future update
-        [[maybe_unused]] std::string_view name;
-        int codeOffset;
-        std::vector<int> flagOffsets;
-        std::vector<std::string> flagNames;
+    /**
+     * Handles into the metadata tables of a `DxData`, resolved once from a name (see `DxInterpreter::sceneId` and
+     * `DxInterpreter::definitionId`) and then used without any hashing. They stay valid for the lifetime of the data,
+     * including across translation changes.
+     */
+    enum class DxSceneId : uint32_t {};
 
-        DxFunction(
-            std::string_view name,
-            int codeOffset,
-            std::vector<int> flagOffsets,
-            std::vector<std::string> flagNames
-        )
-            : name(name), codeOffset(codeOffset), flagOffsets(std::move(flagOffsets)), flagNames(std::move(flagNames))
-        {}
-    };
+    enum class DxFunctionId : uint32_t {};
+
+    enum class DxDefinitionId : uint32_t {};
 
-    struct DxScene
+    /** Types of the sections in a format version 5 binary. Sections of types that aren't known are skipped. */
+    enum class DxSectionType : uint32_t
     {
-        std::string_view name;
-        int codeOffset;
-        std::vector<int> flagOffsets;
-        std::vector<std::string> flagNames;
+        Scenes = 1,
+        Functions = 2,
+        Definitions = 3,
+        Bytecode = 4,
+        Strings = 5,
+        Translations = 6,
+        ExternalFunctions = 7,
+        /** Where each internal translation ends, relative to the first one. */
+        TranslationIndex = 8,
+        /** `DxNameIndex` tables of the scene, function and definition names, one after the other. */
+        NameIndex = 9,
+        /**
+         * Where each internal string starts, then where the last one ends, relative to the first one; then the same
+         * for the internal translations, if there are any. Lets their tables be used in place. Only written into
+         * shared images, see `DxData::publishSharedImage`.
+         */
+        StringOffsets = 10
+    };
 
-        DxScene(std::string_view name, int codeOffset, std::vector<int> flagOffsets, std::vector<std::string> flagNames)
-            : name(name), codeOffset(codeOffset), flagOffsets(std::move(flagOffsets)), flagNames(std::move(flagNames))
-        {}
+    /** An entry of the section directory. `offset` is from the start of the (decompressed) binary content. */
+    struct DxSection
+    {
+        DxSectionType type;
+        uint32_t offset;
+        uint32_t size;
     };
 }
 
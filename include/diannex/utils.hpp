@@ -19,5 +19,6 @@
 
 #include "utils/BinaryReader.hpp"
 #include "utils/DxStack.hpp"
+#include "utils/DxCow.hpp"
 
 #endif //LIBDIANNEX_UTILS_HPP
@@ -17,7 +17,7 @@
 #ifndef LIBDIANNEX_BINARYREADER_HPP
 #define LIBDIANNEX_BINARYREADER_HPP
 
-#include "common.hpp"
+#include "../common.hpp"
 #include <fstream>
 
 namespace diannex
@@ -31,6 +31,11 @@ namespace diannex
         {}
     };
 
+    /**
+     * Sequential source of binary data. Besides the readers here, it can be implemented on top of other sources (such
+     * as a stream out of a pack archive) to load binaries and translations from them, through `DxData::fromReader`
+     * and `DxData::loadTranslation`. Both functions should throw `diannex_exception` when the source runs out.
+     */
     class BinaryReader
     {
     public:
@@ -89,13 +94,27 @@ namespace diannex
 
         void read_n(size_t count, void* val) override;
 
+        /** The next `count` bytes, as a view into the underlying span rather than a copy. */
+        DxByteSpan view_n(size_t count);
+
+        /** Like `read_block`, without copying the block. */
+        DxByteSpan view_block();
+
+        /** Like `read<DxStr>`, without copying the string. Its terminator is skipped, but not part of the view. */
+        DxStrRef view_string();
+
+        static DxPtr<BinarySpanReader> create(DxByteSpan span)
+        {
+            return std::make_shared<make_shared_enabled<BinarySpanReader>>(span);
+        }
+
         template<class T>
-        static BinaryReader::Ptr create(const std::span<T>& span)
+        static DxPtr<BinarySpanReader> create(const std::span<T>& span)
         {
             return std::make_shared<make_shared_enabled<BinarySpanReader>>(span);
         }
 
-        static BinaryReader::Ptr create(const std::vector<std::byte>& vec)
+        static DxPtr<BinarySpanReader> create(const std::vector<std::byte>& vec)
         {
             return std::make_shared<make_shared_enabled<BinarySpanReader>>(vec);
         }
@@ -110,6 +129,35 @@ namespace diannex
             : m_span(vec)
         {}
     };
+
+    /**
+     * Inflates zlib data from another reader while it is being read. Compressed input goes through a small fixed-size
+     * window, and the output is inflated straight into wherever it is read to, so nothing is decompressed up front.
+     */
+    class BinaryInflateReader : public BinaryReader
+    {
+        struct Stream;
+
+        BinaryReader::Ptr m_source;
+        size_t m_remaining;
+        std::unique_ptr<Stream> m_stream;
+
+    public:
+        ~BinaryInflateReader() override;
+
+        void skip(size_t count) override;
+
+        void read_n(size_t count, void* val) override;
+
+        /** Inflates the next `compressedSize` bytes of `source`. */
+        static DxPtr<BinaryInflateReader> create(BinaryReader::Ptr source, size_t compressedSize)
+        {
+            return std::make_shared<make_shared_enabled<BinaryInflateReader>>(std::move(source), compressedSize);
+        }
+
+    protected:
+        BinaryInflateReader(BinaryReader::Ptr source, size_t compressedSize);
+    };
 }
 
 #endif //LIBDIANNEX_BINARYREADER_HPP
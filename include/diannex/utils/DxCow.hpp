@@ -0,0 +1,94 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXCOW_HPP
+#define LIBDIANNEX_DXCOW_HPP
+
+#include "../common.hpp"
+
+#include <atomic>
+
+namespace diannex
+{
+    /**
+     * Implicitly shared value with copy-on-write semantics.
+     *
+     * Copying a DxCow only bumps a reference count. Const access reads the shared value, while non-const access
+     * detaches (deep copies) it first if anyone else still holds a reference.
+     */
+    template<std::copy_constructible T>
+    class DxCow
+    {
+        DxPtr<T> m_ptr;
+    public:
+        using element_type = T;
+
+        DxCow()
+            : m_ptr(std::make_shared<T>())
+        {}
+
+        explicit DxCow(T&& value)
+            : m_ptr(std::make_shared<T>(std::move(value)))
+        {}
+
+        explicit DxCow(const T& value)
+            : m_ptr(std::make_shared<T>(value))
+        {}
+
+        /**
+         * Allocates the value together with its reference count from `resource`. Copies made to detach from a shared
+         * value go on the default resource.
+         */
+        DxCow(T&& value, DxMemoryResource* resource)
+            : m_ptr(std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>{ resource }, std::move(value)))
+        {}
+
+        [[nodiscard]] const T& get() const
+        { return *m_ptr; }
+
+        [[nodiscard]] T& mut()
+        {
+            detach();
+            return *m_ptr;
+        }
+
+        [[nodiscard]] const T& operator*() const
+        { return get(); }
+
+        [[nodiscard]] T& operator*()
+        { return mut(); }
+
+        [[nodiscard]] const T* operator->() const
+        { return m_ptr.get(); }
+
+        [[nodiscard]] T* operator->()
+        { return &mut(); }
+
+        [[nodiscard, maybe_unused]] bool shared() const
+        { return m_ptr.use_count() > 1; }
+
+    private:
+        void detach()
+        {
+            if (m_ptr.use_count() > 1)
+                m_ptr = std::make_shared<T>(std::as_const(*m_ptr));
+            else // Make sure reads by a fork that just released the value on another thread are done before writing
+                std::atomic_thread_fence(std::memory_order_acquire);
+        }
+    };
+}
+
+#endif //LIBDIANNEX_DXCOW_HPP
@@ -0,0 +1,48 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXLZ_HPP
+#define LIBDIANNEX_DXLZ_HPP
+
+#include "../common.hpp"
+
+namespace diannex
+{
+    /**
+     * Fast in-tree LZ codec, for binaries with flag bit 3 set (written by the compiler with `--fast`). It trades some of
+     * zlib's ratio for decompression that runs at close to memory speed.
+     *
+     * The data is a run of frames, each holding up to `LzFrameSize` bytes of the output: a `uint32_t` with the frame's
+     * compressed size (its top bit set if the frame is stored as is), then the frame. A compressed frame is a run of
+     * sequences, each a token byte (literal length in the high nibble, match length minus 4 in the low one), the extra
+     * literal length bytes, the literals, then a 16-bit little-endian distance back into the frame and the extra match
+     * length bytes. A length of 15 in the token carries on into extra bytes, up to the first one that isn't 255. The
+     * last sequence ends after its literals.
+     *
+     * Frames don't refer to each other, so they are decompressed in parallel.
+     */
+    constexpr size_t LzFrameSize = 256 * 1024;
+
+    [[nodiscard]] DxByteBuf lz_compress(DxByteSpan input);
+
+    /**
+     * Decompresses `input` into exactly `output.size()` bytes, with up to `threadCount` threads. Throws
+     * `diannex_exception` if the data is corrupt or doesn't decompress to that size.
+     */
+    void lz_decompress(DxByteSpan input, std::span<std::byte> output, unsigned int threadCount = 1);
+}
+
+#endif //LIBDIANNEX_DXLZ_HPP
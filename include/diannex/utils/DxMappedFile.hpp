@@ -0,0 +1,61 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXMAPPEDFILE_HPP
+#define LIBDIANNEX_DXMAPPEDFILE_HPP
+
+#include "../common.hpp"
+
+namespace diannex
+{
+    /**
+     * Read-only memory mapping of a whole file, unmapped again when destroyed. Pages are only read from disk once they
+     * are touched, and are shared with every other process mapping the same file.
+     *
+     * The file must not be modified while it is mapped.
+     */
+    class DxMappedFile
+    {
+        const std::byte* m_data{ nullptr };
+        size_t m_size{ 0 };
+        #ifdef _WIN32
+        void* m_mapping{ nullptr };
+        #endif
+
+    public:
+        explicit DxMappedFile(const DxStrRef& filename);
+
+        DxMappedFile(const DxMappedFile&) = delete;
+
+        DxMappedFile& operator=(const DxMappedFile&) = delete;
+
+        ~DxMappedFile();
+
+        [[nodiscard]] inline DxByteSpan bytes() const
+        { return { m_data, m_size }; }
+
+        /** Asks for the pages of `range` (part of `bytes`) to be read in ahead of use. */
+        void prefetch(DxByteSpan range) const;
+
+        /**
+         * Lets the pages of `range` (part of `bytes`) be dropped from memory. They stay mapped, so using them again,
+         * including any other data on the same pages, just reads them back in.
+         */
+        void release(DxByteSpan range) const;
+    };
+}
+
+#endif //LIBDIANNEX_DXMAPPEDFILE_HPP
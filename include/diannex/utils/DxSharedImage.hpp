@@ -0,0 +1,79 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#ifndef LIBDIANNEX_DXSHAREDIMAGE_HPP
+#define LIBDIANNEX_DXSHAREDIMAGE_HPP
+
+#include "../common.hpp"
+
+namespace diannex
+{
+    /**
+     * A named shared memory segment holding a binary image, which any process on the host can map read-only by name.
+     * The creating process writes the image once, and everyone (including it) only reads it from then on; each
+     * process maps it wherever it likes, so the image must only refer to its own contents by offset.
+     *
+     * Names follow the platform's rules: POSIX wants a leading slash and no other ones (e.g. `/game-data`), Windows
+     * takes any name, optionally with a `Global\` or `Local\` prefix. On POSIX systems a segment lives on until it is
+     * removed (or the system restarts), on Windows until the last process that has it open closes it.
+     */
+    class DxSharedImage
+    {
+        const std::byte* m_data{ nullptr };
+        size_t m_size{ 0 };
+        #ifdef _WIN32
+        void* m_mapping{ nullptr };
+        #endif
+
+        DxSharedImage() = default;
+
+    public:
+        /**
+         * Where the image starts within the segment, after a header that tells whether it has been written yet. Nine
+         * bytes before a multiple of 8, so that the content of an uncompressed binary image (which starts nine bytes in)
+         * is aligned.
+         */
+        static constexpr size_t ImageOffset = 23;
+
+        /**
+         * Creates the segment `name` holding `parts` one after the other, and maps it read-only. Throws if there is a
+         * segment by that name already. Processes that open it before it is fully written get an exception instead of
+         * a partial image.
+         */
+        [[nodiscard]] static DxPtr<const DxSharedImage> create(const DxStrRef& name, DxROSpan<DxByteSpan> parts);
+
+        /** Maps the existing segment `name` read-only. */
+        [[nodiscard]] static DxPtr<const DxSharedImage> open(const DxStrRef& name);
+
+        /**
+         * Removes the segment `name`, returning whether there was one. Processes that have it mapped keep their
+         * mapping. Nothing to do on Windows, where this always returns false.
+         */
+        static bool remove(const DxStrRef& name);
+
+        DxSharedImage(const DxSharedImage&) = delete;
+
+        DxSharedImage& operator=(const DxSharedImage&) = delete;
+
+        ~DxSharedImage();
+
+        /** The image, without the segment header. */
+        [[nodiscard]] inline DxByteSpan bytes() const
+        { return { m_data + ImageOffset, m_size - ImageOffset }; }
+    };
+}
+
+#endif //LIBDIANNEX_DXSHAREDIMAGE_HPP
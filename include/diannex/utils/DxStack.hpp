@@ -115,6 +115,9 @@ namespace diannex
         [[nodiscard, maybe_unused]] size_type size() const
         { return c.size(); }
 
+        [[nodiscard, maybe_unused]] const Container& container() const
+        { return c; }
+
         [[nodiscard, maybe_unused]] reference peek()
         { return c.back(); }
 
@@ -15,195 +15,990 @@
  * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  *====================================================================================================================*/
 #include "DxData.hpp"
+#include "DxInstructions.hpp"
 
-#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
 
 #include "exceptions.hpp"
 #include "utils/BinaryReader.hpp"
+#include "utils/DxLz.hpp"
+#include "utils/DxMappedFile.hpp"
+#include "utils/DxSharedImage.hpp"
 
 namespace diannex
 {
+    namespace
+    {
+        // Total size of the blocks decoded by DxData::readBlocks, from which it's worth doing so in parallel
+        std::atomic<size_t> parallelLoadSize{ 1024 * 1024 };
+
+        bool load_in_parallel(size_t size)
+        {
+            auto threshold = parallelLoadSize.load(std::memory_order_relaxed);
+            return threshold == 0 || (std::thread::hardware_concurrency() > 1 && size >= threshold);
+        }
+
+        struct Header
+        {
+            int version;
+            bool compressed, lzCompressed, internalTranslation, translationIndex;
+            uint32_t size, compressedSize;
+        };
+
+        Header read_header(BinaryReader& reader, const DxStrRef& name)
+        {
+            if (reader.read<char>() != 'D' || reader.read<char>() != 'N' || reader.read<char>() != 'X')
+                throw data_processing_exception(name, "Not a Diannex binary file (invalid header)");
+
+            Header header{};
+            header.version = reader.read<unsigned char>();
+            if (header.version != 4 && header.version != DxData::FormatVersion)
+                throw data_processing_exception(name,
+                                                "Diannex binary format version is not compatible with this interpreter");
+
+            auto flags = reader.read<uint8_t>();
+            header.compressed = (flags & 1) != 0;
+            header.internalTranslation = (flags & (1 << 1)) != 0;
+            header.translationIndex = (flags & (1 << 2)) != 0;
+            header.lzCompressed = (flags & (1 << 3)) != 0;
+            if (header.compressed && header.lzCompressed)
+                throw data_processing_exception(name, "Binary is flagged with more than one compression format");
+
+            header.size = reader.read<uint32_t>();
+            if (header.compressed || header.lzCompressed)
+                header.compressedSize = reader.read<uint32_t>();
+            return header;
+        }
+
+        DxPtr<DxByteBuf> lz_payload(BinaryReader& reader, const Header& header)
+        {
+            DxByteBuf compressed;
+            DxByteSpan input;
+            if (auto* spanReader = dynamic_cast<BinarySpanReader*>(&reader))
+                input = spanReader->view_n(header.compressedSize);
+            else
+            {
+                compressed.resize(header.compressedSize);
+                reader.read_n(header.compressedSize, compressed.data());
+                input = compressed;
+            }
+
+            auto buffer = std::make_shared<DxByteBuf>(header.size);
+            lz_decompress(input, *buffer, load_in_parallel(header.size) ? std::max(std::thread::hardware_concurrency(), 2u) : 1);
+            return buffer;
+        }
+
+        /** Appends where each of the strings of a string block starts, then where the last one ends. */
+        void append_string_offsets(DxByteSpan block, DxVec<uint32_t>& out)
+        {
+            auto reader = BinarySpanReader::create(block);
+            auto count = reader->read<uint32_t>();
+            auto arena = block.subspan(sizeof(uint32_t));
+            DxStringTable table(arena, count);
+            out.push_back(0);
+            for (size_t i = 0; i < table.size(); ++i)
+                out.push_back((uint32_t)(table[i].data() - (const char*)arena.data() + table[i].size() + 1));
+        }
+
+        DxPtr<const DxByteBuf> read_file(const DxStrRef& filename)
+        {
+            std::ifstream stream(DxStr{ filename }, std::ios::in | std::ios::binary | std::ios::ate);
+            if (!stream)
+                throw data_processing_exception(filename, "Could not open file");
+
+            auto buffer = std::make_shared<DxByteBuf>((size_t)stream.tellg());
+            stream.seekg(0);
+            if (!stream.read((char*)buffer->data(), (std::streamsize)buffer->size()))
+                throw data_processing_exception(filename, "Could not read file");
+            return buffer;
+        }
+
+        DxPtr<const DxByteBuf> read_translation(BinaryReader& reader, const DxStrRef& name)
+        {
+            // The size isn't known up front, but the string count is, so read up to the last terminator
+            auto buffer = std::make_shared<DxByteBuf>(8);
+            try
+            {
+                reader.read_n(buffer->size(), buffer->data());
+                if (std::memcmp(buffer->data(), "DXT", 3) == 0)
+                {
+                    uint32_t stringCount;
+                    std::memcpy(&stringCount, buffer->data() + 4, sizeof(stringCount));
+                    if ((*buffer)[3] == std::byte{ 0 })
+                    {
+                        for (uint32_t i = 0; i < stringCount; ++i)
+                        {
+                            for (auto c = reader.read<std::byte>(); ; c = reader.read<std::byte>())
+                            {
+                                buffer->push_back(c);
+                                if (c == std::byte{ 0 })
+                                    break;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        // Indexed: the last offset in the index is the size of the text after it
+                        auto indexSize = ((size_t)stringCount + 1) * sizeof(uint32_t);
+                        buffer->resize(8 + indexSize);
+                        reader.read_n(indexSize, buffer->data() + 8);
+
+                        uint32_t textSize;
+                        std::memcpy(&textSize, buffer->data() + buffer->size() - sizeof(textSize), sizeof(textSize));
+                        buffer->resize(buffer->size() + textSize);
+                        reader.read_n(textSize, buffer->data() + 8 + indexSize);
+                    }
+                }
+            }
+            catch (const diannex_exception& ex)
+            {
+                throw data_processing_exception(name, ex.what());
+            }
+            return buffer;
+        }
+    }
+
+    [[maybe_unused]]
+    void DxData::parallelLoadThreshold(size_t bytes)
+    {
+        parallelLoadSize.store(bytes, std::memory_order_relaxed);
+    }
+
+    [[maybe_unused]]
+    size_t DxData::parallelLoadThreshold()
+    {
+        return parallelLoadSize.load(std::memory_order_relaxed);
+    }
+
     DxStrRef DxData::string(size_t idx) const
     { return m_strings.at(idx); }
 
     DxStrRef DxData::translation(size_t idx) const
-    { return m_translations.at(idx); }
+    { return language()->translation(idx); }
 
-    DxScene DxData::scene(const diannex::DxStrRef& name) const
-    { return m_scenes.at(name); }
+    DxOpt<DxSceneId> DxData::findScene(const DxStrRef& name) const
+    {
+        if (m_nameIndexed)
+        {
+            auto idx = m_sceneIndex.find(name);
+            if (idx && *idx < m_sceneTable.size() && m_sceneTable.name((DxSceneId)*idx) == name)
+                return (DxSceneId)*idx;
+            return std::nullopt;
+        }
 
-    const DxMap<DxStrRef, DxScene>& DxData::scenes() const
-    { return m_scenes; }
+        auto it = m_sceneIds.find(name);
+        if (it == m_sceneIds.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    DxOpt<DxFunctionId> DxData::findFunction(const DxStrRef& name) const
+    {
+        if (m_nameIndexed)
+        {
+            auto idx = m_functionIndex.find(name);
+            if (idx && *idx < m_functionTable.size() && m_functionTable.name((DxFunctionId)*idx) == name)
+                return (DxFunctionId)*idx;
+            return std::nullopt;
+        }
 
-    DxMap<DxStrRef, DxScene>& DxData::scenes_mut()
-    { return m_scenes; }
+        auto names = m_functionTable.names();
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it == names.end())
+            return std::nullopt;
+        return (DxFunctionId)(it - names.begin());
+    }
 
-    DxROSpan<DxFunction> DxData::functions() const
-    { return { m_functions }; }
+    DxOpt<size_t> DxData::findDefinition(const DxStrRef& name) const
+    {
+        if (m_nameIndexed)
+        {
+            auto idx = m_definitionIndex.find(name);
+            if (idx && *idx < m_definitionNames.size() && m_definitionNames[*idx] == name)
+                return *idx;
+            return std::nullopt;
+        }
 
-    DxSpan<DxFunction> DxData::functions_mut()
-    { return { m_functions }; }
+        auto it = std::lower_bound(m_definitionNames.begin(), m_definitionNames.end(), name);
+        if (it == m_definitionNames.end() || *it != name)
+            return std::nullopt;
+        return it - m_definitionNames.begin();
+    }
 
     DxDefinition DxData::definition(const diannex::DxStrRef& name) const
-    { return m_definitions.at(name); }
+    {
+        auto idx = findDefinition(name);
+        if (!idx)
+            throw diannex_exception("No definition named {}", name);
+        return m_definitions[*idx];
+    }
 
     DxByteSpan DxData::instructions() const
     { return { m_instructions }; }
 
-    void DxData::loadTranslationFile(const diannex::DxStrRef& filename)
+    void DxData::loadTranslationFile(const diannex::DxStrRef& filename, LoadMode mode)
+    {
+        if (mode == LoadMode::Map)
+        {
+            auto mapping = std::make_shared<const DxMappedFile>(filename);
+            loadTranslationBuffer(mapping, mapping->bytes(), filename);
+        }
+        else
+        {
+            auto buffer = read_file(filename);
+            loadTranslationBuffer(buffer, *buffer, filename);
+        }
+    }
+
+    void DxData::loadTranslation(DxByteSpan bytes, const DxStrRef& name)
+    {
+        auto buffer = std::make_shared<const DxByteBuf>(bytes.begin(), bytes.end());
+        loadTranslationBuffer(buffer, *buffer, name);
+    }
+
+    void DxData::loadTranslation(BinaryReader& reader, const DxStrRef& name)
+    {
+        auto buffer = read_translation(reader, name);
+        loadTranslationBuffer(buffer, *buffer, name);
+    }
+
+    void DxData::loadTranslationBuffer(DxPtr<const void> storage, DxByteSpan bytes, const DxStrRef& name,
+                                       const DxOpt<DxStrRef>& language)
     {
-        auto reader = BinaryFileReader::create(std::ifstream(filename.data(), std::ios::in | std::ios::binary));
+        if (bytes.size() < 8)
+            throw data_processing_exception(name, "Not a Diannex binary translation file: invalid header");
+        auto reader = BinarySpanReader::create(bytes);
 
         if (reader->read<char>() != 'D' || reader->read<char>() != 'X' || reader->read<char>() != 'T')
-            throw data_processing_exception(filename, "Not a Diannex binary translation file: invalid header");
+            throw data_processing_exception(name, "Not a Diannex binary translation file: invalid header");
 
-        if (reader->read<uint8_t>() != TranslationFormatVersion)
-            throw data_processing_exception(filename,
+        auto version = reader->read<uint8_t>();
+        if (version > TranslationFormatVersion)
+            throw data_processing_exception(name,
                                             "Diannex translation binary format version is not compatible with this interpreter");
 
         auto stringCount = reader->read<uint32_t>();
-        if (!m_translations.empty() && stringCount != m_translations.size())
-            throw data_processing_exception(filename, "Translation file string count does not match");
+        auto translationCount = this->language()->translationCount();
+        if (translationCount != 0 && stringCount != translationCount)
+            throw data_processing_exception(name, "Translation file string count does not match");
+
+        DxStringTable translations;
+        try
+        {
+            if (version == 0)
+            {
+                translations = DxStringTable(bytes.subspan(8), stringCount);
+            }
+            else
+            {
+                // Indexed: both the index and the text are used where they are, nothing is read until it's shown
+                auto index = reader->view_n(((size_t)stringCount + 1) * sizeof(uint32_t));
+                if ((uintptr_t)index.data() % alignof(uint32_t) != 0)
+                    throw diannex_exception("Translation index is misaligned");
+                translations = DxStringTable::inPlace(bytes.subspan(8 + index.size()),
+                                                      { (const uint32_t*)index.data(), (size_t)stringCount + 1 });
+            }
+        }
+        catch (const diannex_exception& ex)
+        {
+            throw data_processing_exception(name, ex.what());
+        }
+
+        if (!language)
+        {
+            m_language->publish(std::make_shared<const DxLanguage>(*this, std::move(storage), std::move(translations)));
+            return;
+        }
+
+        // Pooled, so that only the text no other language has yet gets stored again, and the buffer can go
+        auto& resident = *m_residentLanguages;
+        DxPtr<DxLanguageSlot> slot;
+        DxVec<const char*> pooled(translations.size());
+        {
+            std::lock_guard lock(resident.mutex);
+            if (!resident.pool)
+            {
+                resident.pool = std::make_shared<DxStringPool>();
+                // Languages tend to share text with the default one, which is in memory anyway
+                auto defaultLanguage = this->language();
+                for (size_t i = 0; i < defaultLanguage->translationCount(); ++i)
+                    resident.pool->adopt(defaultLanguage->translation(i));
+                resident.pool->keep(defaultLanguage);
+            }
+            for (size_t i = 0; i < translations.size(); ++i)
+                pooled[i] = resident.pool->intern(translations.at(i));
+
+            auto& existing = resident.slots[DxStr{ *language }];
+            if (!existing)
+                existing = std::make_shared<DxLanguageSlot>();
+            slot = existing;
+        }
+
+        slot->publish(std::make_shared<const DxLanguage>(*this, resident.pool, std::move(pooled)));
+    }
 
-        // Load text into a cache, so it can be potentially reloaded later
-        if (!m_originalText)
-            m_originalText = std::move(std::exchange(m_translations, {}));
+    void DxData::loadLanguageFile(const DxStrRef& language, const DxStrRef& filename)
+    {
+        auto buffer = read_file(filename);
+        loadTranslationBuffer(buffer, *buffer, filename, language);
+    }
 
-        for (int _ = 0; _ < stringCount; ++_)
-            m_translations.emplace_back(std::move(reader->read<std::string>()));
+    void DxData::loadLanguage(const DxStrRef& language, DxByteSpan bytes)
+    { loadTranslationBuffer(nullptr, bytes, language, language); }
 
-        m_currentCacheID++;
+    void DxData::loadLanguage(const DxStrRef& language, BinaryReader& reader)
+    {
+        auto buffer = read_translation(reader, language);
+        loadTranslationBuffer(buffer, *buffer, language, language);
     }
 
-    DxData DxData::fromFile(const diannex::DxStrRef& filename)
+    std::future<void> DxData::loadLanguageAsync(DxStr language, DxStr filename)
     {
-        auto reader = BinaryFileReader::create(std::ifstream(filename.data(), std::ios::in | std::ios::binary));
+        return std::async(std::launch::async, [this, language = std::move(language), filename = std::move(filename)]
+        { loadLanguageFile(language, filename); });
+    }
 
-        if (reader->read<char>() != 'D' || reader->read<char>() != 'N' || reader->read<char>() != 'X')
-            throw data_processing_exception(filename, "Not a Diannex binary file (invalid header)");
+    DxPtr<const DxLanguage> DxData::language(const DxStrRef& name) const
+    {
+        auto slot = languageSlot(name);
+        auto language = slot->current();
+        if (!language)
+            throw diannex_exception("No language named {}", name);
+        return language;
+    }
 
-        if (reader->read<unsigned char>() != FormatVersion)
-            throw data_processing_exception(filename,
-                                            "Diannex binary format version is not compatible with this interpreter");
+    DxPtr<const DxLanguageSlot> DxData::languageSlot(const DxStrRef& name) const
+    {
+        if (name.empty())
+            return m_language;
+
+        std::lock_guard lock(m_residentLanguages->mutex);
+        auto it = m_residentLanguages->slots.find(DxStr{ name });
+        if (it == m_residentLanguages->slots.end())
+            throw diannex_exception("No language named {}", name);
+        return it->second;
+    }
 
-        auto flags = reader->read<uint8_t>();
-        bool flagCompressed = (flags & 1) != 0;
-        bool flagInternalTranslation = (flags & (1 << 1)) != 0;
+    DxVec<DxStr> DxData::residentLanguages() const
+    {
+        std::lock_guard lock(m_residentLanguages->mutex);
+        DxVec<DxStr> names;
+        for (const auto& [name, _]: m_residentLanguages->slots)
+            names.push_back(name);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
 
-        // Up here so it stays in scope
-        std::vector<std::byte> uncompressedData;
-        if (flagCompressed)
-        {
-            uLongf uncompressedSize = reader->read<uint32_t>();
-            auto size = reader->read<uint32_t>();
-            DxVec<std::byte> tempBuff(size);
-            reader->read_n(size, tempBuff.data());
+    std::future<void> DxData::loadTranslationAsync(DxStr filename, LoadMode mode)
+    {
+        return std::async(std::launch::async, [this, filename = std::move(filename), mode]
+        { loadTranslationFile(filename, mode); });
+    }
 
-            uncompressedData.resize(uncompressedSize);
-            if (uncompress((Bytef*)uncompressedData.data(), &uncompressedSize, (const Bytef*)tempBuff.data(), size) !=
-                Z_OK)
-                throw data_processing_exception(filename, "Diannex binary decompression failed");
+    std::future<void> DxData::loadTranslationAsync(DxPtr<BinaryReader> reader, DxStr name)
+    {
+        return std::async(std::launch::async, [this, reader = std::move(reader), name = std::move(name)]
+        { loadTranslation(*reader, name); });
+    }
+
+    void DxData::residencyBudget(size_t bytes)
+    {
+        if (!m_mapping)
+            throw diannex_exception("Only uncompressed binaries loaded with LoadMode::Map can be paged");
 
-            reader = BinarySpanReader::create(uncompressedData);
+        if (m_pager)
+        {
+            m_pager->budget(bytes);
+            return;
         }
-        else
+
+        m_chunkOffsets.clear();
+        for (uint32_t i = 0; i < m_sceneTable.size(); ++i)
+            m_chunkOffsets.push_back(m_sceneTable.codeOffset((DxSceneId)i));
+        for (uint32_t i = 0; i < m_functionTable.size(); ++i)
+            m_chunkOffsets.push_back(m_functionTable.codeOffset((DxFunctionId)i));
+        std::sort(m_chunkOffsets.begin(), m_chunkOffsets.end());
+
+        m_pager = std::make_shared<DxPager>(m_mapping, m_sceneTable.size() + m_functionTable.size(), bytes);
+    }
+
+    void DxData::pageInChunk(DxPager::Chunk chunk)
+    {
+        m_pager->touch(chunk, [this, chunk]
+        { return chunkRanges(chunk); });
+    }
+
+    DxVec<DxByteSpan> DxData::chunkRanges(DxPager::Chunk chunk) const
+    {
+        auto begin = chunk < m_sceneTable.size()
+                     ? m_sceneTable.codeOffset((DxSceneId)chunk)
+                     : m_functionTable.codeOffset((DxFunctionId)(chunk - m_sceneTable.size()));
+        if (begin < 0)
+            return {};
+
+        // The code of a scene or function goes on until wherever the next one starts
+        auto next = std::upper_bound(m_chunkOffsets.begin(), m_chunkOffsets.end(), begin);
+        size_t end = next == m_chunkOffsets.end() ? m_instructions.size() : (size_t)*next;
+
+        // Then the text it shows, as long as that's in the mapping too rather than in a translation file
+        auto mapped = m_mapping->bytes();
+        auto language = this->language();
+        DxVec<DxByteSpan> text;
+        for (size_t pc = begin; pc < end;)
         {
-            reader->skip(4);
+            auto opcode = (DxOpcode)m_instructions[pc];
+            if ((opcode == DxOpcode::pushs || opcode == DxOpcode::pushints) && pc + 5 <= end)
+            {
+                int32_t idx;
+                std::memcpy(&idx, m_instructions.data() + pc + 1, sizeof(idx));
+                if (idx >= 0 && (size_t)idx < language->translationCount())
+                {
+                    auto str = std::as_bytes(std::span{ language->translation(idx) });
+                    if (str.data() >= mapped.data() && str.data() < mapped.data() + mapped.size())
+                        text.emplace_back(str.data(), str.size() + 1);
+                }
+            }
+            pc += 1 + operand_size(opcode);
         }
 
-        auto sceneBlock = reader->read_block();
-        auto funcBlock = reader->read_block();
-        auto defBlock = reader->read_block();
+        // Text of a scene is mostly stored together, so this tends to end up as one or a few ranges
+        constexpr size_t MergeDistance = 4096;
+        std::sort(text.begin(), text.end(), [](const auto& a, const auto& b)
+        { return a.data() < b.data(); });
 
-        DxData data;
-        data.m_instructions = reader->read_block();
+        DxVec<DxByteSpan> ranges{ m_instructions.subspan(begin, end - begin) };
+        for (const auto& str: text)
+        {
+            auto& last = ranges.back();
+            if (ranges.size() > 1 && str.data() <= last.data() + last.size() + MergeDistance)
+            {
+                auto merged = std::max(last.data() + last.size(), str.data() + str.size());
+                last = { last.data(), (size_t)(merged - last.data()) };
+            }
+            else
+            {
+                ranges.push_back(str);
+            }
+        }
+        return ranges;
+    }
 
-        reader->skip(4); // Ignore size; we're going to process this now
-        auto stringCount = reader->read<uint32_t>();
-        data.m_strings.reserve(stringCount);
+    template<class Reader>
+    void DxData::readBlocks(Reader& reader, int version, bool internalTranslation, bool translationIndex)
+    {
+        // Blocks are used in place when the whole binary is in memory already. Otherwise they are read one by one, the
+        // ones that are kept into storage of their own, and the others into temporaries.
+        constexpr bool InPlace = std::is_same_v<Reader, BinarySpanReader>;
+        struct Blocks
+        {
+            DxByteBuf instructions, strings, translations, names, stringOffsets;
+        };
+        auto blocks = std::make_shared<Blocks>();
 
-        for (int i = 0; i < stringCount; ++i)
-            data.m_strings.emplace_back(std::move(reader->read<std::string>()));
+        auto content = [&reader](size_t size, DxByteBuf& buffer) -> DxByteSpan
+        {
+            if constexpr (InPlace)
+                return reader.view_n(size);
+            else
+            {
+                buffer.resize(size);
+                reader.read_n(size, buffer.data());
+                return buffer;
+            }
+        };
 
-        if (flagInternalTranslation)
+        DxByteBuf sceneBuffer, funcBuffer, defBuffer, externalBuffer, indexBuffer;
+        DxByteSpan sceneBlock, funcBlock, defBlock, strings, translations, index, names, stringOffsets;
+        if (version == 4)
+        {
+            auto block = [&](DxByteBuf& buffer)
+            { return content(reader.template read<uint32_t>(), buffer); };
+
+            sceneBlock = block(sceneBuffer);
+            funcBlock = block(funcBuffer);
+            defBlock = block(defBuffer);
+            m_instructions = block(blocks->instructions);
+            strings = block(blocks->strings);
+            if (internalTranslation)
+                translations = block(blocks->translations);
+            [[maybe_unused]] auto externalFunctionBlock = block(externalBuffer);
+            if (translationIndex)
+                index = block(indexBuffer);
+        }
+        else
         {
-            reader->skip(4); // Ignore size; we're going to process this now
+            // Sections are read in the order they are stored in, so that this still works on a stream
+            m_sections.resize(reader.template read<uint32_t>());
+            reader.read_n(m_sections.size() * sizeof(DxSection), m_sections.data());
+            auto directory = m_sections;
+            std::sort(directory.begin(), directory.end(), [](const auto& a, const auto& b)
+            { return a.offset < b.offset; });
+
+            size_t position = sizeof(uint32_t) + directory.size() * sizeof(DxSection);
+            uint32_t found = 0;
+            for (const auto& section: directory)
+            {
+                if (section.offset < position)
+                    throw diannex_exception("Overlapping sections in the section directory");
+                reader.skip(section.offset - position);
+                position = (size_t)section.offset + section.size;
+
+                std::pair<DxByteSpan*, DxByteBuf*> target;
+                switch (section.type)
+                {
+                    case DxSectionType::Scenes:
+                        target = { &sceneBlock, &sceneBuffer };
+                        break;
+                    case DxSectionType::Functions:
+                        target = { &funcBlock, &funcBuffer };
+                        break;
+                    case DxSectionType::Definitions:
+                        target = { &defBlock, &defBuffer };
+                        break;
+                    case DxSectionType::Bytecode:
+                        target = { &m_instructions, &blocks->instructions };
+                        break;
+                    case DxSectionType::Strings:
+                        target = { &strings, &blocks->strings };
+                        break;
+                    case DxSectionType::Translations:
+                        target = { &translations, &blocks->translations };
+                        break;
+                    case DxSectionType::TranslationIndex:
+                        target = { &index, &indexBuffer };
+                        break;
+                    case DxSectionType::NameIndex:
+                        target = { &names, &blocks->names };
+                        break;
+                    case DxSectionType::StringOffsets:
+                        target = { &stringOffsets, &blocks->stringOffsets };
+                        break;
+                    default:
+                        reader.skip(section.size);
+                        continue;
+                }
+
+                auto bit = 1u << (uint32_t)section.type;
+                if (found & bit)
+                    throw diannex_exception("Section {} appears more than once", (uint32_t)section.type);
+                found |= bit;
+                *target.first = content(section.size, *target.second);
+            }
+
+            for (auto type: { DxSectionType::Scenes, DxSectionType::Functions, DxSectionType::Definitions,
+                              DxSectionType::Bytecode, DxSectionType::Strings })
+            {
+                if (!(found & (1u << (uint32_t)type)))
+                    throw diannex_exception("Section {} is missing", (uint32_t)type);
+            }
+            internalTranslation = (found & (1u << (uint32_t)DxSectionType::Translations)) != 0;
+            translationIndex = (found & (1u << (uint32_t)DxSectionType::TranslationIndex)) != 0;
+            m_nameIndexed = (found & (1u << (uint32_t)DxSectionType::NameIndex)) != 0;
+        }
 
-            auto translationCount = reader->read<uint32_t>();
-            data.m_translations.reserve(translationCount);
+        if (m_nameIndexed)
+        {
+            m_sceneIndex = DxNameIndex::view(names);
+            m_functionIndex = DxNameIndex::view(names);
+            m_definitionIndex = DxNameIndex::view(names);
+        }
 
-            for (int i = 0; i < translationCount; ++i)
-                data.m_translations.emplace_back(std::move(reader->read<std::string>()));
+        // Where each translated string ends, so they don't all have to be scanned for that (or even paged in)
+        DxVec<uint32_t> translationEnds;
+        if (translationIndex)
+        {
+            auto indexReader = BinarySpanReader::create(index);
+            translationEnds.resize(indexReader->read<uint32_t>());
+            indexReader->read_n(translationEnds.size() * sizeof(uint32_t), translationEnds.data());
         }
 
-        [[maybe_unused]] auto externalFunctionBlock = reader->read_block();
+        if constexpr (!InPlace)
+            m_storage = std::move(blocks);
 
-        // Parse scene data
-        reader = BinarySpanReader::create(sceneBlock);
-        auto sceneCount = reader->read<uint32_t>();
-        data.m_scenes.reserve(sceneCount);
-        for (int _1 = 0; _1 < sceneCount; ++_1)
-        {
-            auto sceneName = data.string(reader->read<uint32_t>());
-            auto flagCount = reader->read<uint16_t>() - 1;
-            auto codeOffset = reader->read<int32_t>();
-            std::vector<int> flagOffsets;
-            std::vector<DxStr> flagNames;
-            if (flagCount != 0)
-            {
-                flagOffsets.reserve(flagCount);
+        // Everything is in memory from here on, and the blocks only depend on the strings (for names), so they are
+        // decoded on threads of their own when there's enough of them to make up for starting those
+        auto metadataSize = sceneBlock.size() + funcBlock.size() + defBlock.size() + strings.size();
+        auto policy = load_in_parallel(metadataSize + translations.size()) ? std::launch::async : std::launch::deferred;
+
+        // Offset tables that can be used where they are, taken from the front of `stringOffsets`
+        auto offsetTable = [&stringOffsets](size_t count) -> DxOpt<DxROSpan<uint32_t>>
+        {
+            auto size = (count + 1) * sizeof(uint32_t);
+            if (stringOffsets.size() < size || (uintptr_t)stringOffsets.data() % alignof(uint32_t) != 0)
+                return std::nullopt;
+            DxROSpan<uint32_t> table{ (const uint32_t*)stringOffsets.data(), count + 1 };
+            stringOffsets = stringOffsets.subspan(size);
+            return table;
+        };
+
+        auto stringCount = BinarySpanReader::create(strings)->read<uint32_t>();
+        auto stringTable = offsetTable(stringCount);
+        auto translationCount = internalTranslation ? BinarySpanReader::create(translations)->read<uint32_t>() : 0;
+        auto translationOffsets = internalTranslation && stringTable ? offsetTable(translationCount) : std::nullopt;
+
+        DxStringTable translationTable;
+        auto translationTask = std::async(policy, [&]
+        {
+            if (!internalTranslation)
+                return;
+
+            if (translationOffsets)
+                translationTable = DxStringTable::inPlace(translations.subspan(4), *translationOffsets);
+            else if (!translationIndex)
+                translationTable = DxStringTable(translations.subspan(4), translationCount);
+            else if (translationEnds.size() == translationCount)
+                translationTable = DxStringTable(translations.subspan(4), translationEnds);
+            else
+                throw diannex_exception("Translation index doesn't match the translation count");
+        });
+
+        m_strings = stringTable ? DxStringTable::inPlace(strings.subspan(4), *stringTable)
+                                : DxStringTable(strings.subspan(4), stringCount);
+
+        // Parse function data
+        auto functionTask = std::async(policy, [&]
+        {
+            auto funcReader = BinarySpanReader::create(funcBlock);
+            auto funcCount = funcReader->read<uint32_t>();
+            m_functionTable.reserve(funcCount);
+            DxVec<int32_t> flagOffsets;
+            for (uint32_t _1 = 0; _1 < funcCount; ++_1)
+            {
+                auto funcName = string(funcReader->read<uint32_t>());
+                auto flagCount = funcReader->read<uint16_t>() - 1;
+                auto codeOffset = funcReader->read<int32_t>();
+                flagOffsets.resize(flagCount);
                 for (int _2 = 0; _2 < flagCount; ++_2)
-                    flagOffsets.push_back(reader->read<int32_t>());
-                flagNames.resize(flagCount / 2);
+                    flagOffsets[_2] = funcReader->read<int32_t>();
+                m_functionTable.add(funcName, codeOffset, flagOffsets);
+            }
+        });
+
+        // Parse definition data
+        auto definitionTask = std::async(policy, [&]
+        {
+            auto defReader = BinarySpanReader::create(defBlock);
+            auto defCount = defReader->read<uint32_t>();
+            m_definitionNames.reserve(defCount);
+            m_definitions.reserve(defCount);
+            for (uint32_t _ = 0; _ < defCount; ++_)
+            {
+                auto defName = string(defReader->read<uint32_t>());
+                auto valueStringIndex = defReader->read<uint32_t>();
+                auto codeOffset = defReader->read<int32_t>();
+                auto isInternal = false;
+
+                if (valueStringIndex & (1 << 31))
+                {
+                    isInternal = true;
+                    valueStringIndex &= ~(1 << 31);
+                }
+
+                m_definitionNames.push_back(defName);
+                m_definitions.emplace_back(valueStringIndex, codeOffset, isInternal);
+            }
+
+            // Written sorted by compilers that write a name index; anything older is sorted here
+            if (std::is_sorted(m_definitionNames.begin(), m_definitionNames.end()))
+                return;
+            if (m_nameIndexed)
+                throw diannex_exception("Definitions of a binary with a name index must be sorted by name");
+
+            DxVec<size_t> order(defCount);
+            for (size_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+            std::sort(order.begin(), order.end(), [this](size_t a, size_t b)
+            { return m_definitionNames[a] < m_definitionNames[b]; });
+
+            DxVec<DxStrRef> sortedNames;
+            DxVec<DxDefinition> sortedDefinitions;
+            sortedNames.reserve(defCount);
+            sortedDefinitions.reserve(defCount);
+            for (auto i: order)
+            {
+                sortedNames.push_back(m_definitionNames[i]);
+                sortedDefinitions.push_back(m_definitions[i]);
             }
-            data.m_scenes
-                .emplace(std::make_pair(sceneName,
-                                        DxScene(sceneName, codeOffset, std::move(flagOffsets), std::move(flagNames))));
+            m_definitionNames = std::move(sortedNames);
+            m_definitions = std::move(sortedDefinitions);
+        });
+
+        // Parse scene data
+        auto sceneReader = BinarySpanReader::create(sceneBlock);
+        auto sceneCount = sceneReader->read<uint32_t>();
+        m_sceneTable.reserve(sceneCount);
+        if (!m_nameIndexed)
+            m_sceneIds.reserve(sceneCount);
+        DxVec<int32_t> flagOffsets;
+        for (uint32_t _1 = 0; _1 < sceneCount; ++_1)
+        {
+            auto sceneName = string(sceneReader->read<uint32_t>());
+            auto flagCount = sceneReader->read<uint16_t>() - 1;
+            auto codeOffset = sceneReader->read<int32_t>();
+            flagOffsets.resize(flagCount);
+            for (int _2 = 0; _2 < flagCount; ++_2)
+                flagOffsets[_2] = sceneReader->read<int32_t>();
+            auto id = m_sceneTable.add(sceneName, codeOffset, flagOffsets);
+            if (!m_nameIndexed)
+                m_sceneIds.emplace(sceneName, id);
         }
 
-        // Parse function data
-        reader = BinarySpanReader::create(funcBlock);
-        auto funcCount = reader->read<uint32_t>();
-        data.m_functions.reserve(funcCount);
-        for (int _1 = 0; _1 < funcCount; ++_1)
-        {
-            auto funcName = data.string(reader->read<uint32_t>());
-            auto flagCount = reader->read<uint16_t>() - 1;
-            auto codeOffset = reader->read<int32_t>();
-            std::vector<int> flagOffsets;
-            std::vector<DxStr> flagNames;
-            if (flagCount != 0)
-            {
-                flagOffsets.reserve(flagCount);
-                for (int _2 = 0; _2 < flagCount; ++_2)
-                    flagOffsets.push_back(reader->read<int32_t>());
-                flagNames.resize(flagCount / 2);
+        functionTask.get();
+        definitionTask.get();
+        translationTask.get();
+
+        if (m_nameIndexed && (m_sceneIndex.size() != m_sceneTable.size() ||
+                              m_functionIndex.size() != m_functionTable.size() ||
+                              m_definitionIndex.size() != m_definitions.size()))
+            throw diannex_exception("Name index doesn't match the scenes, functions and definitions");
+
+        m_language->publish(std::make_shared<const DxLanguage>(*this, m_storage, std::move(translationTable)));
+    }
+
+    DxData DxData::fromFile(const diannex::DxStrRef& filename, LoadMode mode)
+    {
+        if (mode == LoadMode::Map)
+        {
+            auto mapping = std::make_shared<const DxMappedFile>(filename);
+            return load(BinarySpanReader::create(mapping->bytes()), filename, mapping, mapping);
+        }
+
+        std::ifstream stream(DxStr{ filename }, std::ios::in | std::ios::binary);
+        if (!stream)
+            throw data_processing_exception(filename, "Could not open file");
+        return load(BinaryFileReader::create(std::move(stream)), filename);
+    }
+
+    DxData DxData::fromMemory(DxByteSpan bytes, const DxStrRef& name)
+    { return load(BinarySpanReader::create(bytes), name); }
+
+    DxData DxData::fromReader(DxPtr<BinaryReader> reader, const DxStrRef& name)
+    { return load(reader, name); }
+
+    std::future<DxData> DxData::loadAsync(DxStr filename, LoadMode mode)
+    {
+        return std::async(std::launch::async, [filename = std::move(filename), mode]
+        { return fromFile(filename, mode); });
+    }
+
+    std::future<DxData> DxData::loadAsync(DxPtr<BinaryReader> reader, DxStr name)
+    {
+        return std::async(std::launch::async, [reader = std::move(reader), name = std::move(name)]
+        { return fromReader(reader, name); });
+    }
+
+    DxData DxData::load(const DxPtr<BinaryReader>& reader, const DxStrRef& name, DxPtr<const void> inPlace,
+                        DxPtr<const DxMappedFile> mapping)
+    {
+        try
+        {
+            auto header = read_header(*reader, name);
+
+            DxData data;
+            if (header.lzCompressed)
+            {
+                // Decompressed whole, then used in place like an uncompressed binary that was read
+                auto buffer = lz_payload(*reader, header);
+                data.m_storage = buffer;
+                data.readBlocks(*BinarySpanReader::create(*buffer), header.version, header.internalTranslation,
+                                header.translationIndex);
             }
-            data.m_functions.emplace_back(funcName, codeOffset, std::move(flagOffsets), std::move(flagNames));
+            else if (header.compressed)
+            {
+                // Inflated block by block while parsing, straight out of the source; a mapping is let go of after
+                data.readBlocks(*BinaryInflateReader::create(reader, header.compressedSize), header.version,
+                                header.internalTranslation, header.translationIndex);
+            }
+            else if (inPlace)
+            {
+                data.m_storage = std::move(inPlace);
+                data.m_mapping = std::move(mapping);
+                data.readBlocks(static_cast<BinarySpanReader&>(*reader), header.version, header.internalTranslation,
+                                header.translationIndex);
+            }
+            else
+            {
+                auto buffer = std::make_shared<DxByteBuf>(header.size);
+                reader->read_n(header.size, buffer->data());
+                data.m_storage = buffer;
+                data.readBlocks(*BinarySpanReader::create(*buffer), header.version, header.internalTranslation,
+                                header.translationIndex);
+            }
+
+            return data;
         }
+        catch (const data_processing_exception&)
+        {
+            throw;
+        }
+        catch (const diannex_exception& ex)
+        {
+            throw data_processing_exception(name, ex.what());
+        }
+    }
 
-        // Parse definition data
-        reader = BinarySpanReader::create(defBlock);
-        auto defCount = reader->read<uint32_t>();
-        data.m_definitions.reserve(defCount);
-        for (int _ = 0; _ < defCount; ++_)
+    DxByteBuf DxData::readSection(const DxStrRef& filename, DxSectionType type)
+    {
+        std::ifstream stream(DxStr{ filename }, std::ios::in | std::ios::binary);
+        if (!stream)
+            throw data_processing_exception(filename, "Could not open file");
+        return readSection(*BinaryFileReader::create(std::move(stream)), type, filename);
+    }
+
+    DxByteBuf DxData::readSection(BinaryReader& reader, DxSectionType type, const DxStrRef& name)
+    {
+        try
+        {
+            auto header = read_header(reader, name);
+            if (header.version < 5)
+                throw data_processing_exception(name, "Binaries before format version 5 have no section directory");
+
+            // Not owned; only used until this returns
+            DxPtr<BinaryReader> content{ DxPtr<BinaryReader>{}, &reader };
+            DxPtr<DxByteBuf> decompressed;
+            if (header.lzCompressed)
+                content = BinarySpanReader::create(*(decompressed = lz_payload(reader, header)));
+            else if (header.compressed)
+                content = BinaryInflateReader::create(content, header.compressedSize);
+
+            DxVec<DxSection> directory(content->read<uint32_t>());
+            content->read_n(directory.size() * sizeof(DxSection), directory.data());
+            auto section = std::find_if(directory.begin(), directory.end(), [type](const auto& section)
+            { return section.type == type; });
+            if (section == directory.end())
+                throw data_processing_exception(name, DxFormat("Binary has no section {}", (uint32_t)type));
+
+            auto directoryEnd = sizeof(uint32_t) + directory.size() * sizeof(DxSection);
+            if (section->offset < directoryEnd)
+                throw data_processing_exception(name, "Section overlaps the section directory");
+            content->skip(section->offset - directoryEnd);
+            DxByteBuf bytes(section->size);
+            content->read_n(bytes.size(), bytes.data());
+            return bytes;
+        }
+        catch (const data_processing_exception&)
+        {
+            throw;
+        }
+        catch (const diannex_exception& ex)
         {
-            auto defName = data.string(reader->read<uint32_t>());
-            auto valueStringIndex = reader->read<uint32_t>();
-            auto codeOffset = reader->read<int32_t>();
-            auto isInternal = false;
+            throw data_processing_exception(name, ex.what());
+        }
+    }
 
-            if (valueStringIndex & (1 << 31))
+    DxData DxData::publishSharedImage(const DxStrRef& filename, const DxStrRef& segment)
+    {
+        DxByteBuf payload;
+        DxVec<DxSection> directory;
+        DxVec<uint32_t> offsets;
+        Header header;
+        try
+        {
+            DxMappedFile file(filename);
+            auto reader = BinarySpanReader::create(file.bytes());
+            header = read_header(*reader, filename);
+            if (header.lzCompressed)
+                payload = std::move(*lz_payload(*reader, header));
+            else
             {
-                isInternal = true;
-                valueStringIndex &= ~(1 << 31);
+                payload.resize(header.size);
+                if (header.compressed)
+                    BinaryInflateReader::create(reader, header.compressedSize)->read_n(header.size, payload.data());
+                else
+                    reader->read_n(header.size, payload.data());
             }
 
-            data.m_definitions.emplace(std::make_pair(defName, DxDefinition(valueStringIndex, codeOffset, isInternal)));
+            // Version 5 binaries get one more section, with the string offsets, unless they have it already
+            if (header.version >= 5)
+            {
+                auto payloadReader = BinarySpanReader::create(payload);
+                directory.resize(payloadReader->read<uint32_t>());
+                payloadReader->read_n(directory.size() * sizeof(DxSection), directory.data());
+
+                DxByteSpan strings, translations;
+                bool hasOffsets = false;
+                for (const auto& section: directory)
+                {
+                    if (section.offset > payload.size() || section.size > payload.size() - section.offset)
+                        throw diannex_exception("Section {} is out of bounds", (uint32_t)section.type);
+                    DxByteSpan bytes{ payload.data() + section.offset, section.size };
+                    if (section.type == DxSectionType::Strings)
+                        strings = bytes;
+                    else if (section.type == DxSectionType::Translations)
+                        translations = bytes;
+                    hasOffsets |= section.type == DxSectionType::StringOffsets;
+                }
+
+                if (!hasOffsets && !strings.empty())
+                {
+                    append_string_offsets(strings, offsets);
+                    if (!translations.empty())
+                        append_string_offsets(translations, offsets);
+                }
+            }
+        }
+        catch (const data_processing_exception&)
+        {
+            throw;
+        }
+        catch (const diannex_exception& ex)
+        {
+            throw data_processing_exception(filename, ex.what());
         }
 
-        data.m_currentCacheID++;
+        // The offsets go last, and the directory grows by their entry, so every other section moves back by that much
+        // (which keeps them aligned)
+        auto directorySize = sizeof(uint32_t) + directory.size() * sizeof(DxSection);
+        auto contentEnd = payload.size() + sizeof(DxSection);
+        auto padding = (alignof(uint32_t) - contentEnd % alignof(uint32_t)) % alignof(uint32_t);
+        auto offsetsSize = offsets.size() * sizeof(uint32_t);
 
-        return data;
+        // Uncompressed, with the same version and translation flags
+        DxByteBuf front;
+        auto write = [&front](const auto& value)
+        {
+            auto offset = front.size();
+            front.resize(offset + sizeof(value));
+            std::memcpy(front.data() + offset, &value, sizeof(value));
+        };
+        for (char c: { 'D', 'N', 'X' })
+            write(c);
+        write((uint8_t)header.version);
+        write((uint8_t)((header.internalTranslation ? 1 << 1 : 0) | (header.translationIndex ? 1 << 2 : 0)));
+        write((uint32_t)(offsets.empty() ? payload.size() : contentEnd + padding + offsetsSize));
+
+        DxByteBuf zeroes(padding);
+        DxVec<DxByteSpan> parts{ front, payload };
+        if (!offsets.empty())
+        {
+            write((uint32_t)directory.size() + 1);
+            for (auto section: directory)
+            {
+                section.offset += sizeof(DxSection);
+                write(section);
+            }
+            write(DxSection{ DxSectionType::StringOffsets, (uint32_t)(contentEnd + padding), (uint32_t)offsetsSize });
+            parts = {
+                front,
+                DxByteSpan{ payload }.subspan(directorySize),
+                zeroes,
+                std::as_bytes(DxROSpan<uint32_t>{ offsets })
+            };
+        }
+
+        auto image = DxSharedImage::create(segment, parts);
+        return load(BinarySpanReader::create(image->bytes()), segment, image);
+    }
+
+    DxData DxData::fromSharedImage(const DxStrRef& segment)
+    {
+        auto image = DxSharedImage::open(segment);
+        return load(BinarySpanReader::create(image->bytes()), segment, image);
     }
-}
\ No newline at end of file
+
+    bool DxData::removeSharedImage(const DxStrRef& segment)
+    { return DxSharedImage::remove(segment); }
+}
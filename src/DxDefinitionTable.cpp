@@ -0,0 +1,62 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxDefinitionTable.hpp"
+
+#include "DxData.hpp"
+#include "DxLanguage.hpp"
+
+#include <algorithm>
+
+namespace diannex
+{
+    DxDefinitionTable::DxDefinitionTable(const DxData& data, const DxLanguage& language)
+        : m_cacheID(language.id())
+    {
+        // Already sorted by name, and in the same order as in `data`, so indices are the same in both
+        auto names = data.definitionNames();
+        m_names.assign(names.begin(), names.end());
+        auto definitions = data.definitions();
+        m_definitions.assign(definitions.begin(), definitions.end());
+
+        m_values.reserve(m_definitions.size());
+        for (const auto& def: m_definitions)
+        {
+            if (def.isInternal)
+                m_values.push_back(data.string(def.valueStringIndex));
+            else if (def.valueStringIndex < language.translationCount())
+                m_values.push_back(language.translation(def.valueStringIndex));
+            else
+                m_values.emplace_back(); // No translation file loaded yet
+        }
+    }
+
+    DxOpt<size_t> DxDefinitionTable::find(const DxStrRef& name) const
+    {
+        auto it = std::lower_bound(m_names.begin(), m_names.end(), name);
+        if (it == m_names.end() || *it != name)
+            return std::nullopt;
+        return it - m_names.begin();
+    }
+
+    std::pair<size_t, size_t> DxDefinitionTable::prefix(const DxStrRef& prefix) const
+    {
+        auto first = std::lower_bound(m_names.begin(), m_names.end(), prefix);
+        auto last = std::find_if_not(first, m_names.end(), [&prefix](const DxStrRef& name)
+        { return name.starts_with(prefix); });
+        return { first - m_names.begin(), last - m_names.begin() };
+    }
+}
@@ -0,0 +1,518 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxExplorer.hpp"
+
+#include "DxInstructions.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_set>
+
+namespace diannex
+{
+    struct DxExplorer::Environment
+    {
+        DxMap<DxStr, DxValue> variables;
+        DxMap<DxStr, DxValue> flags;
+    };
+
+    struct DxExplorer::WorkItem
+    {
+        DxInterpreter interpreter;
+        DxPtr<Environment> env;
+        size_t scene{};
+        DxVec<int> decisions{};
+        size_t instructionCount{};
+    };
+
+    struct DxExplorer::SharedState
+    {
+        std::mutex queueMutex;
+        std::condition_variable queueChanged;
+        std::deque<WorkItem> queue;
+        size_t pending{ 0 };
+
+        std::mutex visitedMutex;
+        std::unordered_set<DxStr> visited;
+
+        std::mutex reportMutex;
+        std::set<size_t> text;
+        // (scene, target offset, is choice) -> whether the option was ever available
+        std::map<std::tuple<size_t, int, bool>, bool> branches;
+        DxVec<DxExplorerPath> paths;
+
+        void push(WorkItem&& item)
+        {
+            {
+                std::lock_guard lock(queueMutex);
+                queue.push_back(std::move(item));
+                pending++;
+            }
+            queueChanged.notify_one();
+        }
+
+        bool visit(DxStr&& key)
+        {
+            std::lock_guard lock(visitedMutex);
+            return visited.insert(std::move(key)).second;
+        }
+    };
+
+    namespace
+    {
+        template<class T>
+        void put(DxStr& key, const T& value)
+        {
+            key.append((const char*)&value, sizeof(value));
+        }
+
+        void put(DxStr& key, DxStrRef str)
+        {
+            put(key, (uint64_t)str.size());
+            key.append(str);
+        }
+
+        // Appends an encoding that no other value shares, or returns false for references, which can't be compared
+        bool put(DxStr& key, const DxValue& value)
+        {
+            put(key, value.type());
+            switch (value.type())
+            {
+                case DxValueType::Integer:
+                    put(key, value.get<int>());
+                    return true;
+                case DxValueType::Double:
+                    put(key, value.get<double>());
+                    return true;
+                case DxValueType::String:
+                    put(key, DxStrRef{ value.get<DxValue::string_type>() });
+                    return true;
+                case DxValueType::Array:
+                {
+                    const auto& arr = value.get<DxValue::array_type>();
+                    put(key, (uint64_t)arr.size());
+                    for (const auto& elem: arr)
+                    {
+                        if (!put(key, elem ? *elem : DxValue{}))
+                            return false;
+                    }
+                    return true;
+                }
+                case DxValueType::Undefined:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        template<class Container>
+        bool put_values(DxStr& key, const Container& values)
+        {
+            put(key, (uint64_t)values.size());
+            for (const auto& value: values)
+            {
+                if (!put(key, value))
+                    return false;
+            }
+            return true;
+        }
+
+        bool put_store(DxStr& key, const DxMap<DxStr, DxValue>& store)
+        {
+            // Sorted by name, since two maps with the same contents can iterate differently
+            DxVec<const std::pair<const DxStr, DxValue>*> entries;
+            entries.reserve(store.size());
+            for (const auto& entry: store)
+                entries.push_back(&entry);
+            std::sort(entries.begin(), entries.end(), [](auto a, auto b)
+            { return a->first < b->first; });
+
+            put(key, (uint64_t)entries.size());
+            for (auto entry: entries)
+            {
+                put(key, DxStrRef{ entry->first });
+                if (!put(key, entry->second))
+                    return false;
+            }
+            return true;
+        }
+
+        void put(DxStr& key, const DxOpt<DxFunctionId>& function)
+        {
+            put(key, function.has_value());
+            if (function)
+                put(key, *function);
+        }
+
+        int32_t read_arg(DxByteSpan code, size_t offset)
+        {
+            int32_t value;
+            std::memcpy(&value, code.data() + offset, sizeof(value));
+            return value;
+        }
+    }
+
+    DxExplorer::DxExplorer(const DxInterpreter& prototype, DxExplorerOptions options)
+        : m_prototype(prototype.fork()), m_options(options)
+    {
+        prepare();
+    }
+
+    DxExplorer::DxExplorer(DxData&& data, DxExplorerOptions options)
+        : m_prototype(std::move(data)), m_options(options)
+    {
+        prepare();
+    }
+
+    void DxExplorer::prepare()
+    {
+        auto& proto = m_prototype;
+        proto.m_state = DxInterpreter::State::Inactive;
+        proto.m_currentScene.reset();
+        proto.clearVMState();
+
+        proto.m_unregisteredFunctionHandler = [](auto)
+        {};
+        if (!m_options.useRegisteredFunctions)
+            proto.m_functionHandlers = {};
+        proto.m_textHandler = [](auto)
+        {};
+        proto.m_choiceHandler = [](auto)
+        {};
+        proto.m_endSceneHandler = [](auto)
+        {};
+        // Every option is offered; choose statements are branched on by the explorer itself
+        proto.m_chanceHandler = [](auto)
+        { return true; };
+        proto.m_weighedChanceHandler = [](const auto&)
+        { return 0; };
+
+        // Flag defaults are evaluated once, then copied into every path
+        m_rootEnvironment = std::make_shared<Environment>();
+        bind(proto, m_rootEnvironment);
+        proto.initializeFlags();
+    }
+
+    void DxExplorer::bind(DxInterpreter& interpreter, const DxPtr<Environment>& env)
+    {
+        interpreter.m_setVariableHandler = [env](DxStrRef name, const DxValue& value)
+        { env->variables.insert_or_assign(DxStr{ name }, value); };
+        interpreter.m_getVariableHandler = [env](DxStrRef name)
+        {
+            auto it = env->variables.find(DxStr{ name });
+            return it != env->variables.end() ? it->second : DxValue{};
+        };
+        interpreter.m_setFlagHandler = [env](DxStrRef name, const DxValue& value)
+        { env->flags.insert_or_assign(DxStr{ name }, value); };
+        interpreter.m_getFlagHandler = [env](DxStrRef name)
+        {
+            auto it = env->flags.find(DxStr{ name });
+            return it != env->flags.end() ? it->second : DxValue{};
+        };
+    }
+
+    DxExplorer::WorkItem DxExplorer::branch(const WorkItem& item, int decision)
+    {
+        WorkItem child{
+            item.interpreter.fork(),
+            std::make_shared<Environment>(*item.env),
+            item.scene,
+            item.decisions,
+            item.instructionCount
+        };
+        bind(child.interpreter, child.env);
+        select(child, item.interpreter.m_state == DxInterpreter::State::InChoice, decision);
+        return child;
+    }
+
+    void DxExplorer::select(WorkItem& item, bool isChoice, int option)
+    {
+        auto& interpreter = item.interpreter;
+        if (isChoice)
+        {
+            interpreter.m_programCounter = interpreter.m_choiceOptions[option].targetOffset;
+            interpreter.m_choiceOptions.clear();
+            interpreter.m_state = DxInterpreter::State::Running;
+        }
+        else
+        {
+            interpreter.m_programCounter = interpreter.m_chooseOptions[option].targetOffset;
+            interpreter.m_chooseOptions.clear();
+        }
+        item.decisions.push_back(option);
+    }
+
+    bool DxExplorer::stateKey(const DxInterpreter& interpreter, const Environment& env, DxStr& key)
+    {
+        put(key, interpreter.m_programCounter);
+        put(key, interpreter.m_state);
+        put(key, interpreter.m_flagCount);
+        put(key, interpreter.m_currentFunction);
+        if (!put_values(key, interpreter.m_stack->container()) || !put_values(key, *interpreter.m_locals))
+            return false;
+
+        put(key, (uint64_t)interpreter.m_callStack->container().size());
+        for (const auto& frame: interpreter.m_callStack->container())
+        {
+            put(key, frame.returnOffset);
+            put(key, frame.flagCount);
+            put(key, frame.function);
+            if (!put_values(key, frame.stack->container()) || !put_values(key, *frame.locals))
+                return false;
+        }
+
+        put(key, (uint64_t)interpreter.m_choiceOptions.size());
+        for (const auto& option: interpreter.m_choiceOptions)
+            put(key, option.targetOffset);
+        put(key, (uint64_t)interpreter.m_chooseOptions.size());
+        for (const auto& option: interpreter.m_chooseOptions)
+        {
+            put(key, option.targetOffset);
+            put(key, option.chance);
+        }
+
+        put(key, interpreter.m_saveRegister.has_value());
+        if (interpreter.m_saveRegister && !put(key, *interpreter.m_saveRegister))
+            return false;
+        return put_store(key, env.variables) && put_store(key, env.flags);
+    }
+
+    void DxExplorer::run(WorkItem item, SharedState& shared) const
+    {
+        using State = DxInterpreter::State;
+
+        auto& interpreter = item.interpreter;
+        auto code = interpreter.m_data->instructions();
+
+        DxVec<size_t> text;
+        DxVec<std::tuple<int, bool, bool>> offered; // target offset, is choice, available
+
+        auto finish = [&](DxPathEnd end, DxStr error = {})
+        {
+            std::lock_guard lock(shared.reportMutex);
+            shared.text.insert(text.begin(), text.end());
+            for (const auto& [target, isChoice, available]: offered)
+            {
+                auto& entry = shared.branches[{ item.scene, target, isChoice }];
+                entry = entry || available;
+            }
+            shared.paths.push_back({
+                                       .scene = item.scene,
+                                       .decisions = std::move(item.decisions),
+                                       .instructionCount = item.instructionCount,
+                                       .end = end,
+                                       .error = std::move(error)
+                                   });
+        };
+
+        // Queues every option but the first as its own path, and continues this one down the first option
+        auto fan_out = [&](bool isChoice, const DxVec<int>& options) -> bool
+        {
+            // E.g. every option's condition was false, or every chance was zero: the interpreter would stop here too
+            if (options.empty())
+            {
+                finish(DxPathEnd::Error, isChoice ? "Choice statement has no choices to present"
+                                                  : "No entries for choose statement");
+                return false;
+            }
+
+            DxStr key;
+            if (stateKey(interpreter, *item.env, key) && !shared.visit(std::move(key)))
+            {
+                finish(DxPathEnd::Merged);
+                return false;
+            }
+
+            for (size_t i = 1; i < options.size(); ++i)
+                shared.push(branch(item, options[i]));
+            select(item, isChoice, options[0]);
+            return true;
+        };
+
+        try
+        {
+            while (true)
+            {
+                switch (interpreter.m_state)
+                {
+                    case State::Running:
+                        break;
+                    case State::InText:
+                        interpreter.m_state = State::Running;
+                        break;
+                    case State::InChoice:
+                    {
+                        DxVec<int> options(interpreter.m_choiceOptions.size());
+                        for (size_t i = 0; i < options.size(); ++i)
+                            options[i] = (int)i;
+                        if (!fan_out(true, options))
+                            return;
+                        break;
+                    }
+                    case State::Inactive:
+                        finish(DxPathEnd::SceneEnd);
+                        return;
+                    default:
+                        finish(DxPathEnd::Error, "Interpreter left the running state unexpectedly");
+                        return;
+                }
+
+                if (item.instructionCount >= m_options.maxInstructionsPerPath)
+                {
+                    finish(DxPathEnd::InstructionLimit);
+                    return;
+                }
+
+                auto pc = interpreter.m_programCounter;
+                auto opcode = (DxOpcode)code[pc];
+                switch (opcode)
+                {
+                    case DxOpcode::pushs:
+                    case DxOpcode::pushints:
+                        text.push_back(read_arg(code, pc + 1));
+                        break;
+
+                    case DxOpcode::choosesel:
+                    {
+                        // Options with no chance of being picked are left for the dead branch report
+                        DxVec<int> options;
+                        for (size_t i = 0; i < interpreter.m_chooseOptions.size(); ++i)
+                        {
+                            if (interpreter.m_chooseOptions[i].chance > 0)
+                                options.push_back((int)i);
+                        }
+
+                        item.instructionCount++;
+                        if (!fan_out(false, options))
+                            return;
+                        continue;
+                    }
+
+                    default:
+                        break;
+                }
+
+                auto choiceCount = interpreter.m_choiceOptions.size();
+                auto chooseCount = interpreter.m_chooseOptions.size();
+                interpreter.interpret(code.subspan(pc));
+                item.instructionCount++;
+
+                switch (opcode)
+                {
+                    case DxOpcode::choiceadd:
+                    case DxOpcode::choiceaddt:
+                        offered.emplace_back(pc + 5 + read_arg(code, pc + 1),
+                                             true,
+                                             interpreter.m_choiceOptions.size() > choiceCount);
+                        break;
+
+                    case DxOpcode::chooseadd:
+                    case DxOpcode::chooseaddt:
+                        offered.emplace_back(pc + 5 + read_arg(code, pc + 1),
+                                             false,
+                                             interpreter.m_chooseOptions.size() > chooseCount &&
+                                             interpreter.m_chooseOptions.back().chance > 0);
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            finish(DxPathEnd::Error, ex.what());
+        }
+    }
+
+    DxExplorerReport DxExplorer::explore()
+    {
+        auto sceneNames = m_prototype.m_data->sceneTable().names();
+        DxVec<DxStrRef> names(sceneNames.begin(), sceneNames.end());
+        std::sort(names.begin(), names.end());
+        return explore(names);
+    }
+
+    DxExplorerReport DxExplorer::explore(const DxVec<DxStrRef>& sceneNames)
+    {
+        DxExplorerReport report;
+        SharedState shared;
+
+        for (size_t i = 0; i < sceneNames.size(); ++i)
+        {
+            report.scenes.emplace_back(sceneNames[i]);
+
+            WorkItem item{ m_prototype.fork(), std::make_shared<Environment>(*m_rootEnvironment), i };
+            bind(item.interpreter, item.env);
+            if (!item.interpreter.enterScene(item.interpreter.sceneId(sceneNames[i])))
+            {
+                report.paths.push_back({ .scene = i });
+                continue;
+            }
+            shared.push(std::move(item));
+        }
+
+        auto threadCount = m_options.threadCount != 0 ? m_options.threadCount : std::thread::hardware_concurrency();
+        DxVec<std::thread> workers;
+        workers.reserve(std::max(threadCount, 1u));
+        for (unsigned int i = 0; i < std::max(threadCount, 1u); ++i)
+        {
+            workers.emplace_back([this, &shared]
+                                 {
+                                     std::unique_lock lock(shared.queueMutex);
+                                     while (true)
+                                     {
+                                         shared.queueChanged.wait(lock, [&shared]
+                                         { return !shared.queue.empty() || shared.pending == 0; });
+                                         if (shared.queue.empty())
+                                             return;
+
+                                         auto item = std::move(shared.queue.front());
+                                         shared.queue.pop_front();
+                                         lock.unlock();
+
+                                         run(std::move(item), shared);
+
+                                         lock.lock();
+                                         if (--shared.pending == 0)
+                                             shared.queueChanged.notify_all();
+                                     }
+                                 });
+        }
+        for (auto& worker: workers)
+            worker.join();
+
+        report.reachableText.assign(shared.text.begin(), shared.text.end());
+        for (const auto& [key, available]: shared.branches)
+        {
+            if (!available)
+                report.deadBranches.push_back({ std::get<0>(key), std::get<1>(key), std::get<2>(key) });
+        }
+
+        std::move(shared.paths.begin(), shared.paths.end(), std::back_inserter(report.paths));
+        std::sort(report.paths.begin(), report.paths.end(), [](const auto& a, const auto& b)
+        { return std::tie(a.scene, a.decisions) < std::tie(b.scene, b.decisions); });
+
+        return report;
+    }
+}
@@ -16,6 +16,7 @@
  *====================================================================================================================*/
 #include "DxInterpreter.hpp"
 
+#include <algorithm>
 #include <random>
 
 namespace diannex
@@ -29,23 +30,46 @@ namespace diannex
     struct DefaultVariableStore
     {
         DxMap<DxStr, DxValue> container;
+    };
+
+    /** Getter and setter over one interpreter's store, held by both so that the getter reads what the setter stored */
+    struct DefaultStoreHandler
+    {
+        DxPtr<DefaultVariableStore> store;
 
-        DxValue operator()(DxStrRef name)
+        DxValue operator()(DxStrRef name) const
         {
-            return container.at(DxStr{ name });
+            auto it = store->container.find(DxStr{ name });
+            return it != store->container.end() ? it->second : DxValue{};
         }
 
-        void operator()(DxStrRef name, const DxValue& value)
+        void operator()(DxStrRef name, const DxValue& value) const
         {
-            container.emplace(std::make_pair(DxStr{ name }, value));
+            store->container.insert_or_assign(DxStr{ name }, value);
         }
     };
 
-    DefaultVariableStore defaultFlagStore;
-    DefaultVariableStore defaultVarStore;
+    /** Gives a fork a copy of whichever default store its getter and setter still use */
+    template<class Getter, class Setter>
+    void fork_default_store(Getter& getter, Setter& setter)
+    {
+        DxPtr<DefaultVariableStore> original, copy;
+        for (auto* handler: { getter.template target<DefaultStoreHandler>(),
+                              setter.template target<DefaultStoreHandler>() })
+        {
+            if (!handler)
+                continue;
+            if (handler->store != original)
+            {
+                original = handler->store;
+                copy = std::make_shared<DefaultVariableStore>(*original);
+            }
+            handler->store = copy;
+        }
+    }
 
     DxInterpreter::DxInterpreter(DxData&& data)
-        : m_data(std::make_shared<DxData>(std::move(data)))
+        : m_data(std::make_shared<DxData>(std::move(data))), m_languageSlot(m_data->languageSlot({}))
     {
         m_unregisteredFunctionHandler = [](auto name)
         { throw diannex_exception("Unregistered function \"{}\"", name); };
@@ -55,12 +79,14 @@ namespace diannex
         m_choiceHandler = stub<void, DxVec<DxStr>>(
             "Missing choice handler. Set one with 'DxInterpreter::choiceHandler' before using the interpreter");
 
-        m_setVariableHandler = defaultVarStore;
-        m_getVariableHandler = defaultVarStore;
-        m_setFlagHandler = defaultFlagStore;
-        m_getFlagHandler = defaultFlagStore;
+        DefaultStoreHandler variables{ std::make_shared<DefaultVariableStore>() };
+        m_setVariableHandler = variables;
+        m_getVariableHandler = variables;
+        DefaultStoreHandler flags{ std::make_shared<DefaultVariableStore>() };
+        m_setFlagHandler = flags;
+        m_getFlagHandler = flags;
 
-        m_functionHandlers.try_emplace("char", [](auto args) -> DxValue
+        m_functionHandlers->try_emplace("char", [](auto args) -> DxValue
         { return DxValue{}; });
         m_endSceneHandler = [](auto name)
         {};
@@ -95,25 +121,81 @@ namespace diannex
         };
     }
 
-    void DxInterpreter::runScene(const DxStrRef& name)
+    DxInterpreter::DxInterpreter(const DxInterpreter& other)
+        : m_data(other.m_data),
+          m_functionHandlers(other.m_functionHandlers),
+          m_state(other.m_state),
+          m_programCounter(other.m_programCounter),
+          m_stack(other.m_stack),
+          m_callStack(other.m_callStack),
+          m_locals(other.m_locals),
+          m_choiceOptions(other.m_choiceOptions),
+          m_chooseOptions(other.m_chooseOptions),
+          m_saveRegister(other.m_saveRegister),
+          m_flagCount(other.m_flagCount),
+          m_currentScene(other.m_currentScene),
+          m_currentFunction(other.m_currentFunction),
+          m_startingChoice(other.m_startingChoice),
+          m_languageSlot(other.m_languageSlot),
+          m_languageName(other.m_languageName),
+          m_language(other.m_language),
+          m_flagsInitialized(other.m_flagsInitialized),
+          m_sceneFlags(other.m_sceneFlags),
+          m_functionFlags(other.m_functionFlags),
+          m_pendingData(other.m_pendingData),
+          m_pendingLanguageSlot(other.m_pendingLanguageSlot),
+          m_unregisteredFunctionHandler(other.m_unregisteredFunctionHandler),
+          m_textHandler(other.m_textHandler),
+          m_setVariableHandler(other.m_setVariableHandler),
+          m_getVariableHandler(other.m_getVariableHandler),
+          m_endSceneHandler(other.m_endSceneHandler),
+          m_chanceHandler(other.m_chanceHandler),
+          m_weighedChanceHandler(other.m_weighedChanceHandler),
+          m_setFlagHandler(other.m_setFlagHandler),
+          m_getFlagHandler(other.m_getFlagHandler),
+          m_choiceHandler(other.m_choiceHandler)
+    {
+        fork_default_store(m_getVariableHandler, m_setVariableHandler);
+        fork_default_store(m_getFlagHandler, m_setFlagHandler);
+    }
+
+    DxInterpreter DxInterpreter::fork() const
+    {
+        return DxInterpreter(*this);
+    }
+
+    [[maybe_unused]]
+    DxSceneId DxInterpreter::sceneId(const DxStrRef& name) const
+    {
+        auto id = m_data->findScene(name);
+        if (!id)
+            throw diannex_exception("No scene named {}", name);
+        return *id;
+    }
+
+    bool DxInterpreter::enterScene(DxSceneId scene)
     {
-        m_currentScene.emplace(std::move(m_data->scene(name)));
-        m_programCounter = m_currentScene->codeOffset;
+        const auto& scenes = m_data->sceneTable();
+        m_currentScene = scene;
+        m_programCounter = scenes.codeOffset(scene);
         if (m_programCounter == -1)
-            return;
+            return false;
         m_state = State::Running;
         clearVMState();
+        DX_PROFILE_LEAVE_ALL(m_profiler);
+        DX_PROFILE_ENTER(m_profiler, scenes.name(scene), true);
+
+        m_data->pageIn(scene);
+        if (!m_sceneFlags.get().ready(scene))
+            prepareFlags(scenes, m_sceneFlags.mut(), scene);
 
         // Load flags into local variables
-        auto& flagNames = m_currentScene->flagNames;
-        for (const auto& flagName: flagNames)
-            m_locals.emplace_back(std::move(m_getFlagHandler(flagName)));
+        m_currentFunction.reset();
+        m_flagCount = (int)scenes.flagCount(scene);
+        for (const auto& flagName: m_sceneFlags.get().names(scenes, scene))
+            m_locals->emplace_back(std::move(m_getFlagHandler(flagName)));
 
-        auto buff = m_data->instructions();
-        while (m_state == State::Running)
-        {
-            interpret(buff.subspan(m_programCounter));
-        }
+        return true;
     }
 
     [[maybe_unused]]
@@ -123,73 +205,213 @@ namespace diannex
             m_state = State::Paused;
     }
 
-    void DxInterpreter::resumeScene()
+    [[maybe_unused]]
+    void DxInterpreter::startScene(const DxStrRef& name)
     {
-        if (m_state == State::Paused || m_state == State::InText)
-            m_state = State::Running;
+        startScene(sceneId(name));
+    }
 
-        auto buff = m_data->instructions();
-        while (m_state == State::Running)
-            interpret(buff.subspan(m_programCounter));
+    [[maybe_unused]]
+    void DxInterpreter::startScene(DxSceneId scene)
+    {
+        if (enterScene(scene))
+            m_state = State::Suspended;
     }
 
     void DxInterpreter::endScene()
     {
         m_state = State::Inactive;
-        auto name = m_currentScene->name;
+        auto name = m_data->sceneTable().name(*m_currentScene);
         m_currentScene.reset();
-        clearVMState();
+        releaseVMState();
+        DX_PROFILE_LEAVE_ALL(m_profiler);
         m_endSceneHandler(name);
+
+        // The handler may have started another scene, which finishes on the old data as well
+        if (m_pendingData && m_state == State::Inactive)
+            swapData();
     }
 
-    void DxInterpreter::selectChoice(int idx)
+    [[maybe_unused]]
+    void DxInterpreter::memoryResource(DxMemoryResource* resource)
+    {
+        assert_state(State::Inactive, "Memory resource can't be changed while a scene is running");
+        m_memoryResource = resource ? resource : std::pmr::get_default_resource();
+    }
+
+    [[maybe_unused]]
+    bool DxInterpreter::reload(DxData&& data)
+    {
+        return reload(std::make_shared<DxData>(std::move(data)));
+    }
+
+    [[maybe_unused]]
+    bool DxInterpreter::reload(DxPtr<DxData> data)
+    {
+        // Looked up now, so that a missing language is reported to the caller rather than from `endScene`
+        m_pendingLanguageSlot = data->languageSlot(m_languageName);
+        m_pendingData = std::move(data);
+        if (m_state != State::Inactive)
+            return false;
+
+        swapData();
+        return true;
+    }
+
+    void DxInterpreter::swapData()
+    {
+        m_data = std::move(m_pendingData);
+        m_languageSlot = std::move(m_pendingLanguageSlot);
+        m_language.reset();
+
+        // Definitions are numbered differently in the new data, so every cached value goes
+        m_definitionTable.reset();
+        m_definitionValues.clear();
+        m_definitionStorage.clear();
+        m_definitionResolved.clear();
+        m_globalDependents.clear();
+        m_nativeDependents.clear();
+
+        // Flags already set keep their values, only ones new to this version get their defaults
+        m_sceneFlags = {};
+        m_functionFlags = {};
+        if (m_flagsInitialized)
+            prepareAllFlags();
+    }
+
+    [[maybe_unused]]
+    void DxInterpreter::selectChoiceDeferred(int idx)
     {
         assert_state(State::InChoice, "Attempting to select choice in invalid state");
 
         m_programCounter = m_choiceOptions[idx].targetOffset;
         m_choiceOptions.clear();
+        m_state = State::Suspended;
+    }
 
-        m_state = State::Running;
-        auto buff = m_data->instructions();
-        while (m_state == State::Running)
-            interpret(buff.subspan(m_programCounter));
+    [[maybe_unused]]
+    void DxInterpreter::language(const DxStrRef& name)
+    {
+        m_languageSlot = m_data->languageSlot(name);
+        m_languageName = name;
+        m_language.reset();
+    }
+
+    [[maybe_unused]]
+    DxDefinitionId DxInterpreter::definitionId(const DxStrRef& name) const
+    {
+        auto idx = m_data->findDefinition(name);
+        if (!idx)
+            throw diannex_exception("No definition named {}", name);
+        return (DxDefinitionId)*idx;
     }
 
     [[maybe_unused]]
     DxStrRef DxInterpreter::definition(const DxStrRef& name)
     {
-        if (!m_definitions.contains(name))
-        {
-            auto baseDef = m_data->definition(name);
-            _internal::DxDefinitionInstance instance{
-                baseDef,
-                m_data,
-                shared_from_this()
-            };
-            m_definitions.emplace(std::make_pair(name, instance));
-        }
-        return m_definitions.at(name).value();
+        return definition(definitionId(name));
     }
 
-    DxValue DxInterpreter::executeEval(int address)
+    [[maybe_unused]]
+    DxStrRef DxInterpreter::definition(DxDefinitionId id)
     {
-        assert_state(State::Inactive,
-                     "Invalid evaluation state in interpreter - make a separate interpreter?");
+        syncDefinitions();
+        if ((size_t)id >= m_definitionTable->size())
+            throw diannex_exception("Invalid definition id {}", (size_t)id);
+        return resolveDefinition((size_t)id);
+    }
 
-        m_state = State::Eval;
-        m_programCounter = address;
+    [[maybe_unused]]
+    DxInterpreter::DefinitionRange DxInterpreter::definitions(const DxStrRef& prefix)
+    {
+        syncDefinitions();
+        auto [first, last] = m_definitionTable->prefix(prefix);
+        for (auto i = first; i < last; ++i)
+            resolveDefinition(i);
+
+        return {
+            m_definitionTable->names().subspan(first, last - first),
+            DxROSpan<DxStrRef>{ m_definitionValues }.subspan(first, last - first)
+        };
+    }
 
-        auto buff = m_data->instructions();
-        while (m_state == State::Eval)
-            interpret(buff.subspan(m_programCounter));
+    void DxInterpreter::syncDefinitions()
+    {
+        syncLanguage();
+        const auto& table = m_language->definitionTable();
+        if (m_definitionTable == table)
+            return;
+
+        // New language (or first use): start over from the shared values, dynamic ones get evaluated on demand
+        m_definitionTable = table;
+        auto values = table->values();
+        m_definitionValues.assign(values.begin(), values.end());
+        m_definitionStorage.clear();
+        m_definitionStorage.resize(table->size());
+        m_definitionResolved.resize(table->size());
+        for (size_t i = 0; i < table->size(); ++i)
+            m_definitionResolved[i] = !table->isDynamic(i);
+        m_globalDependents.clear();
+        m_nativeDependents.clear();
+    }
+
+    DxStrRef DxInterpreter::resolveDefinition(size_t idx)
+    {
+        if (m_definitionResolved[idx])
+            return m_definitionValues[idx];
+
+        m_evaluatingDefinition = idx;
+        executeEvalMultiple<DependencyTracker>(m_definitionTable->definition(idx).codeOffset);
+        auto& stack = m_stack.mut();
+        auto elemCount = stack.size();
+        DxVec<DxStr> elems(elemCount);
+        for (decltype(elemCount) i = 0; i < elemCount; ++i)
+            elems[i] = stack.pop().safe_get<DxValueType::String>();
+
+        m_definitionStorage[idx] = interpolate(m_definitionTable->values()[idx], elems);
+        m_definitionValues[idx] = m_definitionStorage[idx];
+        m_definitionResolved[idx] = true;
+        return m_definitionValues[idx];
+    }
+
+    void DxInterpreter::addDependency(DxMap<DxStr, DxVec<size_t>>& dependents, const DxStrRef& name)
+    {
+        // Edges from earlier evaluations are kept; at worst they cause one unnecessary re-evaluation
+        auto& list = dependents[DxStr{ name }];
+        if (std::find(list.begin(), list.end(), m_evaluatingDefinition) == list.end())
+            list.push_back(m_evaluatingDefinition);
+    }
+
+    void DxInterpreter::invalidateDependents(DxMap<DxStr, DxVec<size_t>>& dependents, const DxStrRef& name)
+    {
+        auto it = dependents.find(DxStr{ name });
+        if (it == dependents.end())
+            return;
+        for (auto idx: it->second)
+            m_definitionResolved[idx] = false;
+    }
 
-        return std::move(m_stack.pop());
+    [[maybe_unused]]
+    void DxInterpreter::invalidateGlobal(const DxStrRef& name)
+    { invalidateDependents(m_globalDependents, name); }
+
+    [[maybe_unused]]
+    void DxInterpreter::invalidateNative(const DxStrRef& name)
+    { invalidateDependents(m_nativeDependents, name); }
+
+    [[maybe_unused]]
+    void DxInterpreter::invalidateDefinitions()
+    {
+        if (!m_definitionTable)
+            return;
+        for (size_t i = 0; i < m_definitionTable->size(); ++i)
+            m_definitionResolved[i] = !m_definitionTable->isDynamic(i);
     }
 
-    void DxInterpreter::executeEvalMultiple(int address)
+    DxValue DxInterpreter::executeEval(int address)
     {
         assert_state(State::Inactive,
-                     "Invalid execution state in interpreter - make a separate interpreter?");
+                     "Invalid evaluation state in interpreter - make a separate interpreter?");
 
         m_state = State::Eval;
         m_programCounter = address;
@@ -197,13 +419,16 @@ namespace diannex
         auto buff = m_data->instructions();
         while (m_state == State::Eval)
             interpret(buff.subspan(m_programCounter));
+
+        return exported(m_stack->pop());
     }
 
-    DxStr DxInterpreter::interpolate(const DxStrRef& str, const DxROSpan<DxStr>& elems)
+    /** Appends `str` to `result` with its placeholders filled in, for text on the heap or on a memory resource */
+    template<class Str>
+    void interpolate_into(Str& result, const DxStrRef& str, const DxROSpan<Str>& elems)
     {
         auto elemCount = elems.size();
 
-        DxStrBuilder result;
         for (auto pos = 0; pos < str.length(); ++pos)
         {
             auto c = str.at(pos);
@@ -218,11 +443,11 @@ namespace diannex
                 if (str.at(pos + 1) == '{')
                 {
                     pos += 2; // Skip '${' from interpolation string
-                    DxStrBuilder build;
+                    DxStr build;
                     c = str.at(pos);
                     do
                     {
-                        build << c;
+                        build += c;
                         pos++;
                         c = str.at(pos);
                     }
@@ -232,20 +457,20 @@ namespace diannex
                     {
                         // Backtrack; ignore this
                         pos = startPos + 1;
-                        result << '$';
+                        result += '$';
                         continue;
                     }
 
                     int index;
                     try
                     {
-                        index = std::stoi(build.str());
+                        index = std::stoi(build);
                     }
                     catch (...)
                     {
                         // Backtrack; ignore this
                         pos = startPos + 1;
-                        result << '$';
+                        result += '$';
                         continue;
                     }
 
@@ -253,24 +478,37 @@ namespace diannex
                     {
                         // Backtrack; ignore this;
                         pos = startPos + 1;
-                        result << '$';
+                        result += '$';
                         continue;
                     }
 
-                    result << elems[index];
+                    result += elems[index];
                     continue;
                 }
             }
 
-            result << c;
+            result += c;
         }
+    }
 
-        return result.str();
+    DxStr DxInterpreter::interpolate(const DxStrRef& str, const DxROSpan<DxStr>& elems)
+    {
+        DxStr result;
+        interpolate_into(result, str, elems);
+        return result;
+    }
+
+    DxPmrStr DxInterpreter::interpolate(const DxStrRef& str, const DxROSpan<DxPmrStr>& elems,
+                                        DxMemoryResource* resource)
+    {
+        DxPmrStr result{ resource };
+        interpolate_into(result, str, elems);
+        return result;
     }
 
     void DxInterpreter::registerFunctionSafe(const DxStrRef& name, const DxFuncSig& func)
     {
-        m_functionHandlers.insert_or_assign(name, func);
+        m_functionHandlers->insert_or_assign(name, func);
     }
 
     #define setter(name, callback, field) \
@@ -298,40 +536,49 @@ namespace diannex
 
     setter(choiceHandler, ChoiceCallback, m_choiceHandler)
 
-    bool DxInterpreter::initializeFlags()
+    DxValue DxInterpreter::evaluateNested(int address)
     {
-        if (m_flagsInitialized)
-        {
-            resetFlags();
-            return false;
-        }
+        // Like executeEval, but from within a running scene or call, which is picked up again afterwards
+        auto state = std::exchange(m_state, State::Eval);
+        auto programCounter = std::exchange(m_programCounter, address);
+
+        auto buff = m_data->instructions();
+        while (m_state == State::Eval)
+            interpret(buff.subspan(m_programCounter));
+
+        m_state = state;
+        m_programCounter = programCounter;
+        return m_stack->pop();
+    }
 
-        for (auto& [_, scene]: m_data->scenes_mut())
+    template<class Id>
+    void DxInterpreter::prepareFlags(const DxCodeTable<Id>& table, DxFlagNames<Id>& flags, Id id)
+    {
+        auto valueOffsets = table.flagValueOffsets(id);
+        auto nameOffsets = table.flagNameOffsets(id);
+        auto names = flags.prepare(table, id);
+        for (size_t i = 0; i < names.size(); ++i)
         {
-            for (int i = 0; i < scene.flagOffsets.size(); i += 2)
-            {
-                auto value = executeEval(scene.flagOffsets[i]);
-                auto name = executeEval(scene.flagOffsets[i + 1])
-                    .convert(DxValueType::String)
-                    .get<DxStr>();
-                auto& n = scene.flagNames[i / 2] = std::move(name);
-                m_setFlagHandler(n, value);
-            }
+            auto value = evaluateNested(valueOffsets[i]);
+            names[i] = evaluateNested(nameOffsets[i]).template safe_get<DxValueType::String>();
+            if (m_getFlagHandler(names[i]).type() == DxValueType::Undefined)
+                m_setFlagHandler(names[i], exported(std::move(value)));
         }
+        flags.setReady(id);
+    }
+
+    template void DxInterpreter::prepareFlags(const DxCodeTable<DxSceneId>&, DxFlagNames<DxSceneId>&, DxSceneId);
+    template void DxInterpreter::prepareFlags(const DxCodeTable<DxFunctionId>&, DxFlagNames<DxFunctionId>&, DxFunctionId);
 
-        for (auto& function: m_data->functions_mut())
+    bool DxInterpreter::initializeFlags()
+    {
+        if (m_flagsInitialized)
         {
-            for (int i = 0; i < function.flagOffsets.size(); i += 2)
-            {
-                auto value = executeEval(function.flagOffsets[i]);
-                auto name = executeEval(function.flagOffsets[i + 1])
-                    .convert(DxValueType::String)
-                    .get<DxStr>();
-                auto& n = function.flagNames[i / 2] = std::move(name);
-                m_setFlagHandler(n, value);
-            }
+            resetFlags();
+            return false;
         }
 
+        prepareAllFlags();
         m_flagsInitialized = true;
 
         return true;
@@ -339,31 +586,35 @@ namespace diannex
 
     void DxInterpreter::resetFlags()
     {
-        if (!m_flagsInitialized)
-        {
-            initializeFlags();
-            return;
-        }
+        prepareAllFlags();
+        m_flagsInitialized = true;
 
-        for (const auto& [_, scene]: m_data->scenes())
+        auto reset = [this]<class Id>(const DxCodeTable<Id>& table, const DxFlagNames<Id>& flags)
         {
-            for (int i = 0; i < scene.flagOffsets.size(); i += 2)
+            for (uint32_t i = 0; i < table.size(); ++i)
             {
-                auto value = executeEval(scene.flagOffsets[i]);
-                auto name = scene.flagNames[i / 2];
-                m_setFlagHandler(name, value);
+                auto valueOffsets = table.flagValueOffsets((Id)i);
+                auto names = flags.names(table, (Id)i);
+                for (size_t j = 0; j < names.size(); ++j)
+                    m_setFlagHandler(names[j], exported(evaluateNested(valueOffsets[j])));
             }
-        }
+        };
+        reset(m_data->sceneTable(), m_sceneFlags.get());
+        reset(m_data->functionTable(), m_functionFlags.get());
+    }
 
-        for (const auto& function: m_data->functions())
+    void DxInterpreter::prepareAllFlags()
+    {
+        auto prepare = [this]<class Id>(const DxCodeTable<Id>& table, DxCow<DxFlagNames<Id>>& flags)
         {
-            for (int i = 0; i < function.flagOffsets.size(); i += 2)
+            for (uint32_t i = 0; i < table.size(); ++i)
             {
-                auto value = executeEval(function.flagOffsets[i]);
-                auto name = function.flagNames[i / 2];
-                m_setFlagHandler(name, value);
+                if (!flags.get().ready((Id)i))
+                    prepareFlags(table, flags.mut(), (Id)i);
             }
-        }
+        };
+        prepare(m_data->sceneTable(), m_sceneFlags);
+        prepare(m_data->functionTable(), m_functionFlags);
     }
 
     double DxInterpreter::random_real(double min, double max)
@@ -385,9 +636,21 @@ namespace diannex
 
     void DxInterpreter::clearVMState()
     {
-        m_stack.clear();
-        m_callStack.clear();
-        m_locals.clear();
+        // Reassign rather than clear, so that a fork still sharing this state keeps its copy intact
+        m_stack = makeStack();
+        m_callStack = { FrameStack{ DxPmrVec<StackFrame>{ m_memoryResource } }, m_memoryResource };
+        m_locals = makeLocals();
+        m_choiceOptions.clear();
+        m_chooseOptions.clear();
+        m_saveRegister.reset();
+    }
+
+    void DxInterpreter::releaseVMState()
+    {
+        // Empty and on the default resource, so that the memory resource can be released by the end scene handler
+        m_stack = {};
+        m_callStack = {};
+        m_locals = {};
         m_choiceOptions.clear();
         m_chooseOptions.clear();
         m_saveRegister.reset();
@@ -397,7 +660,7 @@ namespace diannex
         const diannex::DxInterpreter& interpreter,
         const std::string_view& message
     )
-        : diannex_exception("Diannex Runtime Error (scene: {}): {}", interpreter.m_currentScene->name, message)
+        : diannex_exception("Diannex Runtime Error (scene: {}): {}", interpreter.m_data->sceneTable().name(*interpreter.m_currentScene), message)
     {}
 
     void DxInterpreter::panic(const std::string_view& message)
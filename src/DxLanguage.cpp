@@ -0,0 +1,42 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxLanguage.hpp"
+#include "DxDefinitionTable.hpp"
+
+#include <atomic>
+
+namespace diannex
+{
+    namespace
+    {
+        std::atomic<int> g_nextLanguageId{ 0 };
+    }
+
+    DxLanguage::DxLanguage(const DxData& data, DxPtr<const void> storage, DxStringTable translations)
+        : m_id(g_nextLanguageId.fetch_add(1, std::memory_order_relaxed)), m_storage(std::move(storage)),
+          m_translations(std::move(translations))
+    {
+        m_definitionTable = std::make_shared<const DxDefinitionTable>(data, *this);
+    }
+
+    DxLanguage::DxLanguage(const DxData& data, DxPtr<const void> storage, DxVec<const char*> translations)
+        : m_id(g_nextLanguageId.fetch_add(1, std::memory_order_relaxed)), m_storage(std::move(storage)),
+          m_pooled(std::move(translations))
+    {
+        m_definitionTable = std::make_shared<const DxDefinitionTable>(data, *this);
+    }
+}
@@ -0,0 +1,172 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxNameIndex.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "exceptions.hpp"
+
+namespace diannex
+{
+    namespace
+    {
+        uint64_t hash_name(const DxStrRef& name)
+        {
+            // Eight (little-endian) bytes at a time, the last ones padded with zeroes, MurmurHash3 style
+            auto mix = [](uint64_t hash, uint64_t block)
+            { return std::rotl(hash ^ (block * 0x87C37B91114253D5u), 27) * 0x4CF5AD432745937Fu; };
+
+            uint64_t hash = name.size();
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= name.size(); i += sizeof(uint64_t))
+            {
+                uint64_t block;
+                std::memcpy(&block, name.data() + i, sizeof(block));
+                hash = mix(hash, block);
+            }
+            if (i < name.size())
+            {
+                uint64_t block = 0;
+                for (size_t j = 0; i + j < name.size(); ++j)
+                    block |= (uint64_t)(uint8_t)name[i + j] << (8 * j);
+                hash = mix(hash, block);
+            }
+            return DxNameIndex::fmix(hash);
+        }
+    }
+
+    DxOpt<uint32_t> DxNameIndex::find(const DxStrRef& name) const
+    {
+        if (m_size == 0)
+            return std::nullopt;
+
+        auto nameHash = hash_name(name);
+        int32_t seed;
+        std::memcpy(&seed, m_table + (size_t)bucket(nameHash, m_size) * sizeof(int32_t), sizeof(seed));
+        auto at = seed < 0 ? (uint64_t)(-(int64_t)seed - 1) : slot(nameHash, (uint32_t)seed, m_size);
+        if (at >= m_size)
+            return std::nullopt;
+
+        uint32_t index;
+        std::memcpy(&index, m_table + ((size_t)m_size + at) * sizeof(uint32_t), sizeof(index));
+        return index;
+    }
+
+    uint64_t DxNameIndex::hash(const DxStrRef& name)
+    { return hash_name(name); }
+
+    DxNameIndex DxNameIndex::view(DxByteSpan& bytes)
+    {
+        if (bytes.size() < sizeof(uint32_t))
+            throw diannex_exception("Name index is truncated");
+
+        uint32_t count;
+        std::memcpy(&count, bytes.data(), sizeof(count));
+        auto size = sizeof(uint32_t) + (size_t)count * 2 * sizeof(uint32_t);
+        if (bytes.size() < size)
+            throw diannex_exception("Name index is truncated");
+
+        // Not checked any further here, so that none of it has to be read (or paged in) at load; see `find`
+        DxNameIndex index;
+        index.m_table = bytes.data() + sizeof(uint32_t);
+        index.m_size = count;
+        bytes = bytes.subspan(size);
+        return index;
+    }
+
+    void DxNameIndex::build(DxROSpan<DxStrRef> names, DxByteBuf& out)
+    {
+        auto count = (uint32_t)names.size();
+        DxVec<uint64_t> hashes(count);
+        for (uint32_t i = 0; i < count; ++i)
+            hashes[i] = hash(names[i]);
+
+        // No seed separates names with the same hash, which are almost certainly the same name
+        DxVec<uint32_t> byHash(count);
+        for (uint32_t i = 0; i < count; ++i)
+            byHash[i] = i;
+        std::sort(byHash.begin(), byHash.end(), [&hashes](uint32_t a, uint32_t b)
+        { return hashes[a] < hashes[b]; });
+        auto same = std::adjacent_find(byHash.begin(), byHash.end(), [&hashes](uint32_t a, uint32_t b)
+        { return hashes[a] == hashes[b]; });
+        if (same != byHash.end())
+            throw diannex_exception("Names {} and {} can't both be in a name index", names[same[0]], names[same[1]]);
+
+        DxVec<DxVec<uint32_t>> buckets(count);
+        for (uint32_t i = 0; i < count; ++i)
+            buckets[bucket(hashes[i], count)].push_back(i);
+
+        DxVec<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b)
+        { return buckets[a].size() > buckets[b].size(); });
+
+        // Biggest buckets first, each with the first seed that puts all its names in free slots
+        DxVec<int32_t> seeds(count, 0);
+        DxVec<uint32_t> indices(count, 0);
+        DxVec<uint8_t> taken(count, 0);
+        DxVec<uint32_t> slots;
+        size_t next = 0;
+        for (auto bucket: order)
+        {
+            const auto& members = buckets[bucket];
+            if (members.size() > 1)
+            {
+                for (uint32_t seed = 1;; ++seed)
+                {
+                    slots.clear();
+                    for (auto member: members)
+                    {
+                        auto at = slot(hashes[member], seed, count);
+                        if (taken[at] || std::find(slots.begin(), slots.end(), at) != slots.end())
+                            break;
+                        slots.push_back(at);
+                    }
+                    if (slots.size() != members.size())
+                        continue;
+
+                    seeds[bucket] = (int32_t)seed;
+                    for (size_t i = 0; i < members.size(); ++i)
+                    {
+                        taken[slots[i]] = 1;
+                        indices[slots[i]] = members[i];
+                    }
+                    break;
+                }
+            }
+            else if (members.size() == 1)
+            {
+                // Single names go straight into whatever slot is left
+                while (taken[next])
+                    next++;
+                taken[next] = 1;
+                seeds[bucket] = -(int32_t)next - 1;
+                indices[next] = members[0];
+            }
+        }
+
+        auto offset = out.size();
+        out.resize(offset + sizeof(uint32_t) + (size_t)count * 2 * sizeof(uint32_t));
+        std::memcpy(out.data() + offset, &count, sizeof(count));
+        std::memcpy(out.data() + offset + sizeof(uint32_t), seeds.data(), count * sizeof(int32_t));
+        std::memcpy(out.data() + offset + sizeof(uint32_t) + count * sizeof(int32_t), indices.data(),
+                    count * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,89 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxPager.hpp"
+
+#include "utils/DxMappedFile.hpp"
+
+namespace diannex
+{
+    DxPager::DxPager(DxPtr<const DxMappedFile> file, size_t chunkCount, size_t budget)
+        : m_file(std::move(file)), m_budget(budget), m_chunks(chunkCount)
+    {}
+
+    size_t DxPager::budget() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_budget;
+    }
+
+    void DxPager::budget(size_t bytes)
+    {
+        std::lock_guard lock(m_mutex);
+        m_budget = bytes;
+        evictLocked();
+    }
+
+    size_t DxPager::residentBytes() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_residentBytes;
+    }
+
+    size_t DxPager::residentChunks() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_recent.size();
+    }
+
+    void DxPager::touchLocked(Chunk chunk)
+    {
+        auto& state = m_chunks[chunk];
+        if (state.resident)
+        {
+            m_recent.splice(m_recent.begin(), m_recent, state.position);
+        }
+        else
+        {
+            state.size = 0;
+            for (auto range: state.ranges)
+            {
+                m_file->prefetch(range);
+                state.size += range.size();
+            }
+            state.resident = true;
+            state.position = m_recent.insert(m_recent.begin(), chunk);
+            m_residentBytes += state.size;
+        }
+        m_mostRecent.store(chunk, std::memory_order_relaxed);
+
+        evictLocked();
+    }
+
+    void DxPager::evictLocked()
+    {
+        // The most recently used chunk stays, even if it doesn't fit on its own
+        while (m_residentBytes > m_budget && m_recent.size() > 1)
+        {
+            auto& state = m_chunks[m_recent.back()];
+            for (auto range: state.ranges)
+                m_file->release(range);
+            state.resident = false;
+            m_residentBytes -= state.size;
+            m_recent.pop_back();
+        }
+    }
+}
@@ -0,0 +1,188 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxProfiler.hpp"
+
+#include <algorithm>
+
+namespace diannex
+{
+    namespace
+    {
+        DxStr json_escape(const DxStrRef& str)
+        {
+            DxStrBuilder out;
+            for (char c: str)
+            {
+                if (c == '"' || c == '\\')
+                    out << '\\' << c;
+                else if ((unsigned char)c < 0x20)
+                    out << DxFormat("\\u{:04x}", (int)c);
+                else
+                    out << c;
+            }
+            return out.str();
+        }
+    }
+
+    void DxProfiler::reset()
+    {
+        m_opcodes = {};
+        m_frames.clear();
+        m_frameIndices.clear();
+        m_paths.clear();
+        m_pathIndices.clear();
+        m_natives.clear();
+        m_programCounters.clear();
+        m_activeFrames.clear();
+    }
+
+    void DxProfiler::enterFrame(DxStrRef name, bool isScene)
+    {
+        auto [frameIt, newFrame] = m_frameIndices.try_emplace(DxStr{ name }, m_frames.size());
+        if (newFrame)
+            m_frames.push_back({ .name = DxStr{ name }, .isScene = isScene });
+        m_frames[frameIt->second].calls++;
+
+        auto pathName = m_activeFrames.empty()
+                        ? DxStr{ name }
+                        : DxFormat("{};{}", m_paths[m_activeFrames.back().path].name, name);
+        auto [pathIt, newPath] = m_pathIndices.try_emplace(pathName, m_paths.size());
+        if (newPath)
+            m_paths.push_back({ std::move(pathName), 0 });
+
+        m_activeFrames.push_back({ frameIt->second, pathIt->second, 0 });
+    }
+
+    void DxProfiler::leaveFrame()
+    {
+        if (m_activeFrames.empty())
+            return;
+
+        auto frame = m_activeFrames.back();
+        m_activeFrames.pop_back();
+        m_frames[frame.frame].inclusiveNanoseconds += frame.inclusiveNanoseconds;
+        if (!m_activeFrames.empty())
+            m_activeFrames.back().inclusiveNanoseconds += frame.inclusiveNanoseconds;
+    }
+
+    void DxProfiler::leaveAllFrames()
+    {
+        while (!m_activeFrames.empty())
+            leaveFrame();
+    }
+
+    void DxProfiler::recordInstruction(int programCounter, DxOpcode opcode, Clock::duration elapsed)
+    {
+        auto ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+        auto& op = m_opcodes[(size_t)opcode];
+        op.count++;
+        op.nanoseconds += ns;
+        m_programCounters[programCounter]++;
+
+        if (!m_activeFrames.empty())
+        {
+            auto& active = m_activeFrames.back();
+            active.inclusiveNanoseconds += ns;
+            m_frames[active.frame].exclusiveNanoseconds += ns;
+            m_paths[active.path].nanoseconds += ns;
+        }
+    }
+
+    void DxProfiler::recordNative(DxStrRef name, Clock::duration elapsed)
+    {
+        auto& native = m_natives[DxStr{ name }];
+        native.calls++;
+        native.nanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    DxStr DxProfiler::toJson() const
+    {
+        DxStrBuilder out;
+        bool first = true;
+
+        out << "{\n  \"opcodes\": [";
+        for (size_t i = 0; i < m_opcodes.size(); ++i)
+        {
+            if (m_opcodes[i].count == 0)
+                continue;
+            out << (first ? "" : ",") << DxFormat(R"(
+    {{ "opcode": "{}", "count": {}, "nanoseconds": {} }})",
+                                                  opcode_name((DxOpcode)i),
+                                                  m_opcodes[i].count,
+                                                  m_opcodes[i].nanoseconds);
+            first = false;
+        }
+
+        for (bool scenes: { true, false })
+        {
+            out << DxFormat("\n  ],\n  \"{}\": [", scenes ? "scenes" : "functions");
+            first = true;
+            for (const auto& frame: m_frames)
+            {
+                if (frame.isScene != scenes)
+                    continue;
+                out << (first ? "" : ",") << DxFormat(R"(
+    {{ "name": "{}", "calls": {}, "inclusiveNanoseconds": {}, "exclusiveNanoseconds": {} }})",
+                                                      json_escape(frame.name),
+                                                      frame.calls,
+                                                      frame.inclusiveNanoseconds,
+                                                      frame.exclusiveNanoseconds);
+                first = false;
+            }
+        }
+
+        out << "\n  ],\n  \"natives\": [";
+        first = true;
+        for (const auto& [name, native]: m_natives)
+        {
+            out << (first ? "" : ",") << DxFormat(R"(
+    {{ "name": "{}", "calls": {}, "nanoseconds": {} }})",
+                                                  json_escape(name),
+                                                  native.calls,
+                                                  native.nanoseconds);
+            first = false;
+        }
+
+        DxVec<std::pair<int, uint64_t>> hot(m_programCounters.begin(), m_programCounters.end());
+        std::sort(hot.begin(), hot.end(), [](const auto& a, const auto& b)
+        { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+
+        out << "\n  ],\n  \"programCounters\": [";
+        first = true;
+        for (const auto& [pc, count]: hot)
+        {
+            out << (first ? "" : ",") << DxFormat(R"(
+    {{ "pc": {}, "count": {} }})", pc, count);
+            first = false;
+        }
+        out << "\n  ]\n}\n";
+
+        return out.str();
+    }
+
+    DxStr DxProfiler::toCollapsedStacks() const
+    {
+        DxStrBuilder out;
+        for (const auto& path: m_paths)
+        {
+            if (path.nanoseconds != 0)
+                out << path.name << ' ' << path.nanoseconds << '\n';
+        }
+        return out.str();
+    }
+}
@@ -0,0 +1,105 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxStringPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace diannex
+{
+    const char* DxStringPool::intern(DxStrRef str)
+    {
+        if ((m_size + 1) * 2 > m_slots.size())
+            rehash(std::max<size_t>(m_slots.size() * 2, 1024));
+
+        auto& pooled = slot(str);
+        if (!pooled)
+        {
+            pooled = store(str);
+            m_size++;
+        }
+        return pooled;
+    }
+
+    const char* DxStringPool::adopt(DxStrRef str)
+    {
+        if ((m_size + 1) * 2 > m_slots.size())
+            rehash(std::max<size_t>(m_slots.size() * 2, 1024));
+
+        auto& pooled = slot(str);
+        if (!pooled)
+        {
+            pooled = str.data();
+            m_size++;
+        }
+        return pooled;
+    }
+
+    void DxStringPool::keep(DxPtr<const void> storage)
+    {
+        m_storage.push_back(std::move(storage));
+    }
+
+    const char*& DxStringPool::slot(DxStrRef str)
+    {
+        // Open addressing with linear probing, the table is kept at most half full
+        auto mask = m_slots.size() - 1;
+        for (auto i = std::hash<DxStrRef>{}(str) & mask; ; i = (i + 1) & mask)
+        {
+            auto& pooled = m_slots[i];
+            if (!pooled || (std::strncmp(pooled, str.data(), str.size()) == 0 && pooled[str.size()] == '\0'))
+                return pooled;
+        }
+    }
+
+    const char* DxStringPool::store(DxStrRef str)
+    {
+        auto size = str.size() + 1;
+        char* out;
+        if (size > ChunkSize / 4)
+        {
+            // Long enough to waste much of a chunk, so it gets one of its own
+            out = m_chunks.emplace_back(std::make_unique<char[]>(size)).get();
+        }
+        else
+        {
+            if (m_chunkFree < size)
+            {
+                m_chunkNext = m_chunks.emplace_back(std::make_unique<char[]>(ChunkSize)).get();
+                m_chunkFree = ChunkSize;
+            }
+            out = m_chunkNext;
+            m_chunkNext += size;
+            m_chunkFree -= size;
+        }
+
+        std::memcpy(out, str.data(), str.size());
+        out[str.size()] = '\0';
+        m_bytes += size;
+        return out;
+    }
+
+    void DxStringPool::rehash(size_t slotCount)
+    {
+        auto old = std::exchange(m_slots, DxVec<const char*>(slotCount));
+        for (const auto* pooled: old)
+        {
+            if (pooled)
+                slot(pooled) = pooled;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "DxStringTable.hpp"
+
+#include <cstring>
+
+#include "exceptions.hpp"
+
+namespace diannex
+{
+    DxStringTable::DxStringTable(DxByteSpan arena, size_t count)
+        : m_arena((const char*)arena.data()), m_arenaSize(arena.size())
+    {
+        if (arena.size() > UINT32_MAX)
+            throw diannex_exception("String table is too large");
+
+        m_offsets.reserve(count + 1);
+        auto begin = m_arena;
+        auto end = m_arena + arena.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto terminator = begin == end ? nullptr : (const char*)std::memchr(begin, 0, end - begin);
+            if (!terminator)
+                throw diannex_exception("Unexpected end of data: {} of {} strings terminated", i, count);
+
+            begin = terminator + 1;
+            m_offsets.push_back((uint32_t)(begin - m_arena));
+        }
+    }
+
+    DxStringTable::DxStringTable(DxByteSpan arena, DxROSpan<uint32_t> ends)
+        : m_arena((const char*)arena.data()), m_arenaSize(arena.size())
+    {
+        m_offsets.reserve(ends.size() + 1);
+        for (auto end: ends)
+        {
+            // Every string takes up at least its terminator, and all of them are within the arena
+            if (end <= m_offsets.back() || end > arena.size())
+                throw diannex_exception("Invalid string index: string {} ends at {}", m_offsets.size() - 1, end);
+            m_offsets.push_back(end);
+        }
+    }
+
+    DxStringTable DxStringTable::inPlace(DxByteSpan arena, DxROSpan<uint32_t> offsets)
+    {
+        if (offsets.empty())
+            throw diannex_exception("Invalid string index: no end offset");
+
+        DxStringTable table;
+        table.m_arena = (const char*)arena.data();
+        table.m_arenaSize = arena.size();
+        table.m_index = offsets;
+        return table;
+    }
+
+    DxStrRef DxStringTable::at(size_t idx) const
+    {
+        if (idx >= size())
+            throw std::out_of_range(DxFormat("String index {} is out of range ({} strings)", idx, size()));
+
+        if (!m_index.empty())
+        {
+            // Not checked up front, see `inPlace`
+            auto begin = m_index[idx];
+            auto end = m_index[idx + 1];
+            if (begin >= end || end > m_arenaSize || m_arena[end - 1] != '\0')
+                throw diannex_exception("Invalid string index: string {} is at {} to {}", idx, begin, end);
+        }
+        return (*this)[idx];
+    }
+}
@@ -16,6 +16,7 @@
  *====================================================================================================================*/
 #include "DxValue.hpp"
 
+#include <charconv>
 #include <cmath>
 
 namespace diannex
@@ -31,12 +32,20 @@ namespace diannex
         : m_value((int)value), m_type(DxValueType::Integer)
     {}
 
+    DxValue::DxValue(const DxStr& value, DxValueType type)
+        : m_value(string_type{ value }), m_type(type)
+    {}
+
+    DxValue::DxValue(DxStrRef value, DxMemoryResource* resource)
+        : m_value(string_type{ value, resource }), m_type(DxValueType::String)
+    {}
+
     void DxValue::detect_type()
     {
         auto inner = m_value.value();
         if (std::holds_alternative<array_type>(inner))
             m_type = DxValueType::Array;
-        else if (std::holds_alternative<DxStr>(inner))
+        else if (std::holds_alternative<string_type>(inner))
             m_type = DxValueType::String;
         else if (std::holds_alternative<int>(inner))
             m_type = DxValueType::Integer;
@@ -46,6 +55,27 @@ namespace diannex
             m_type = DxValueType::Reference;
     }
 
+    DxValue DxValue::copy(DxMemoryResource* resource) const
+    {
+        if (!m_value)
+            return *this;
+
+        if (auto str = std::get_if<string_type>(&*m_value))
+            return DxValue{ string_type{ *str, resource }, m_type };
+
+        if (auto arr = std::get_if<array_type>(&*m_value))
+        {
+            std::pmr::polymorphic_allocator<DxValue> allocator{ resource };
+            array_type result(resource);
+            result.reserve(arr->size());
+            for (const auto& elem: *arr)
+                result.push_back(elem ? std::allocate_shared<DxValue>(allocator, elem->copy(resource)) : nullptr);
+            return DxValue{ std::move(result), m_type };
+        }
+
+        return *this;
+    }
+
     DxValue DxValue::convert(diannex::DxValueType newType) const
     {
         if (m_type == newType || newType == DxValueType::Undefined)
@@ -70,7 +100,11 @@ namespace diannex
                     case DxValueType::Double:
                         return DxValue{ (double)std::get<int>(*m_value), DxValueType::Double };
                     case DxValueType::String:
-                        return DxValue{ std::to_string(std::get<int>(*m_value)), DxValueType::String };
+                    {
+                        char buffer[16];
+                        auto end = std::to_chars(std::begin(buffer), std::end(buffer), std::get<int>(*m_value)).ptr;
+                        return DxValue{ DxStrRef{ buffer, (size_t)(end - buffer) }, std::pmr::get_default_resource() };
+                    }
                     default:
                         break;
                 }
@@ -79,9 +113,9 @@ namespace diannex
                 switch (newType)
                 {
                     case DxValueType::Double:
-                        return DxValue{ std::stod(std::get<std::string>(*m_value)), DxValueType::Double };
+                        return DxValue{ std::stod(DxStr{ std::get<string_type>(*m_value) }), DxValueType::Double };
                     case DxValueType::Integer:
-                        return DxValue{ std::stoi(std::get<std::string>(*m_value)), DxValueType::Integer };
+                        return DxValue{ std::stoi(DxStr{ std::get<string_type>(*m_value) }), DxValueType::Integer };
                     default:
                         break;
                 }
@@ -102,6 +136,14 @@ namespace diannex
         throw value_conversion_exception(m_type, newType);
     }
 
+    static DxValue::string_type concat(const DxValue::string_type& lhs, const DxValue::string_type& rhs)
+    {
+        DxValue::string_type result{ lhs.get_allocator() };
+        result.reserve(lhs.size() + rhs.size());
+        result.append(lhs).append(rhs);
+        return result;
+    }
+
     #pragma region Operators
 
     #define op_convert_cond(op, cond) \
@@ -160,17 +202,22 @@ namespace diannex
         op_branch(op, double, Double); \
         op_branch(op, int, Integer))
 
+    // Joined strings are allocated from the resource of the left one, so that they stay in a scene's memory resource
+    #define op_concat_branch \
+    case DxValueType::String: \
+        return DxValue{ concat(this->get<string_type>(), rhs.get<string_type>()), DxValueType::String }
+
     #define operator_dis(op, cond) \
     op_signature_cond(op, cond,         \
         op_branch(op, double, Double); \
         op_branch(op, int, Integer);   \
-        op_branch(op, std::string, String))
+        op_concat_branch)
 
     #define operator_disu(op, if_both_null, if_both_not_null) \
     op_nullcheck_signature_cond(op, if_both_null, if_both_not_null, m_type == DxValueType::Double && rhs.m_type == DxValueType::Integer,\
         op_branch(op, double, Double);                        \
         op_branch(op, int, Integer);                          \
-        op_branch(op, std::string, String))
+        op_branch(op, string_type, String))
 
     operator_dis(+,
                  m_type == DxValueType::String || (m_type == DxValueType::Double && rhs.m_type == DxValueType::Integer))
@@ -16,6 +16,12 @@
  *====================================================================================================================*/
 #include "utils/BinaryReader.hpp"
 
+#include <array>
+#include <cstring>
+#include <zlib.h>
+
+#include "exceptions.hpp"
+
 namespace diannex
 {
     DxByteBuf BinaryReader::read_block()
@@ -40,7 +46,8 @@ namespace diannex
         if (!val)
             throw std::invalid_argument("destination pointer was null!");
 
-        m_stream.read((char*)val, (std::streamsize)count);
+        if (!m_stream.read((char*)val, (std::streamsize)count))
+            throw diannex_exception("Unexpected end of file");
     }
 
     void BinarySpanReader::skip(size_t count)
@@ -50,10 +57,88 @@ namespace diannex
 
     void BinarySpanReader::read_n(size_t count, void* val)
     {
+        auto data = view_n(count);
+        std::memcpy(val, data.data(), count);
+    }
+
+    DxByteSpan BinarySpanReader::view_n(size_t count)
+    {
+        if (count > m_span.size())
+            throw diannex_exception("Unexpected end of data: {} bytes needed, {} left", count, m_span.size());
+
         auto data = m_span.first(count);
-        auto out = (std::byte*)val;
-        for (size_t i = 0; i < count; ++i, ++out)
-            *out = data[i];
         skip(count);
+        return data;
+    }
+
+    DxByteSpan BinarySpanReader::view_block()
+    { return view_n(read<uint32_t>()); }
+
+    DxStrRef BinarySpanReader::view_string()
+    {
+        auto end = m_span.empty() ? nullptr : (const std::byte*)std::memchr(m_span.data(), 0, m_span.size());
+        if (!end)
+            throw diannex_exception("Unexpected end of data: unterminated string");
+
+        DxStrRef str{ (const char*)m_span.data(), (size_t)(end - m_span.data()) };
+        skip(str.size() + 1);
+        return str;
+    }
+
+    struct BinaryInflateReader::Stream
+    {
+        z_stream zs{};
+        std::array<std::byte, 64 * 1024> window{};
+    };
+
+    BinaryInflateReader::BinaryInflateReader(BinaryReader::Ptr source, size_t compressedSize)
+        : m_source(std::move(source)), m_remaining(compressedSize), m_stream(std::make_unique<Stream>())
+    {
+        if (inflateInit(&m_stream->zs) != Z_OK)
+            throw diannex_exception("Could not initialize zlib");
+    }
+
+    BinaryInflateReader::~BinaryInflateReader()
+    {
+        inflateEnd(&m_stream->zs);
+    }
+
+    void BinaryInflateReader::skip(size_t count)
+    {
+        std::array<std::byte, 4096> scratch; // NOLINT(*-pro-type-member-init)
+        while (count != 0)
+        {
+            auto chunk = std::min(count, scratch.size());
+            read_n(chunk, scratch.data());
+            count -= chunk;
+        }
+    }
+
+    void BinaryInflateReader::read_n(size_t count, void* val)
+    {
+        auto& zs = m_stream->zs;
+        zs.next_out = (Bytef*)val;
+        zs.avail_out = (uInt)count;
+
+        while (zs.avail_out != 0)
+        {
+            if (zs.avail_in == 0)
+            {
+                auto chunk = std::min(m_remaining, m_stream->window.size());
+                if (chunk == 0)
+                    throw diannex_exception("Unexpected end of compressed data");
+
+                m_source->read_n(chunk, m_stream->window.data());
+                m_remaining -= chunk;
+                zs.next_in = (Bytef*)m_stream->window.data();
+                zs.avail_in = (uInt)chunk;
+            }
+
+            auto result = inflate(&zs, Z_NO_FLUSH);
+            if (result == Z_STREAM_END && zs.avail_out != 0)
+                throw diannex_exception("Unexpected end of compressed data");
+            if (result != Z_OK && result != Z_STREAM_END)
+                throw diannex_exception("Decompression failed: {}", zs.msg ? zs.msg : "corrupt data");
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,265 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "utils/DxLz.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+#include "exceptions.hpp"
+
+namespace diannex
+{
+    namespace
+    {
+        constexpr size_t MinMatch = 4;
+        constexpr size_t MaxDistance = 65535;
+        constexpr int HashBits = 16;
+        constexpr uint32_t StoredFrame = 1u << 31;
+
+        struct Frame
+        {
+            DxByteSpan input;
+            std::span<std::byte> output;
+            bool stored;
+        };
+
+        inline uint32_t load32(const std::byte* ptr)
+        {
+            uint32_t value;
+            std::memcpy(&value, ptr, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t hash(uint32_t sequence)
+        { return (sequence * 2654435761u) >> (32 - HashBits); }
+
+        void write_length(DxByteBuf& out, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+                out.push_back(std::byte{ 255 });
+            out.push_back((std::byte)length);
+        }
+
+        void write_sequence(DxByteBuf& out, const std::byte* literals, size_t literalLength, size_t distance,
+                            size_t matchLength)
+        {
+            auto matchCode = matchLength - MinMatch;
+            out.push_back((std::byte)((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+            if (literalLength >= 15)
+                write_length(out, literalLength - 15);
+            out.insert(out.end(), literals, literals + literalLength);
+            if (matchLength == 0)
+                return;
+
+            out.push_back((std::byte)(distance & 0xFF));
+            out.push_back((std::byte)(distance >> 8));
+            if (matchCode >= 15)
+                write_length(out, matchCode - 15);
+        }
+
+        void compress_frame(DxByteSpan frame, DxByteBuf& out, DxVec<uint32_t>& table)
+        {
+            std::fill(table.begin(), table.end(), 0);
+
+            const auto* base = frame.data();
+            size_t size = frame.size(), anchor = 0, pos = 0;
+            while (pos + MinMatch <= size)
+            {
+                auto sequence = load32(base + pos);
+                auto& slot = table[hash(sequence)];
+                size_t candidate = slot;
+                slot = (uint32_t)pos;
+                if (candidate >= pos || pos - candidate > MaxDistance || load32(base + candidate) != sequence)
+                {
+                    pos++;
+                    continue;
+                }
+
+                size_t length = MinMatch;
+                while (pos + length < size && base[candidate + length] == base[pos + length])
+                    length++;
+                while (pos > anchor && candidate > 0 && base[pos - 1] == base[candidate - 1])
+                {
+                    pos--;
+                    candidate--;
+                    length++;
+                }
+
+                write_sequence(out, base + anchor, pos - anchor, pos - candidate, length);
+                pos += length;
+                anchor = pos;
+                if (pos + MinMatch <= size)
+                    table[hash(load32(base + pos - 2))] = (uint32_t)(pos - 2);
+            }
+
+            // Only literals are left; the frame ends after them, without a match
+            write_sequence(out, base + anchor, size - anchor, 0, 0);
+        }
+
+        size_t read_length(const std::byte*& in, const std::byte* end, size_t length)
+        {
+            if (length != 15)
+                return length;
+
+            uint8_t extra;
+            do
+            {
+                if (in == end)
+                    throw diannex_exception("Corrupt LZ data (truncated length)");
+                extra = (uint8_t)*in++;
+                length += extra;
+            } while (extra == 255);
+            return length;
+        }
+
+        void decompress_frame(const Frame& frame)
+        {
+            if (frame.stored)
+            {
+                if (frame.input.size() != frame.output.size())
+                    throw diannex_exception("Corrupt LZ data (stored frame of the wrong size)");
+                std::memcpy(frame.output.data(), frame.input.data(), frame.input.size());
+                return;
+            }
+
+            const auto* in = frame.input.data();
+            const auto* inEnd = in + frame.input.size();
+            auto* out = frame.output.data();
+            auto* const outStart = out;
+            auto* const outEnd = out + frame.output.size();
+
+            while (true)
+            {
+                if (in == inEnd)
+                    throw diannex_exception("Corrupt LZ data (truncated frame)");
+                auto token = (uint8_t)*in++;
+
+                auto literalLength = read_length(in, inEnd, token >> 4);
+                if (literalLength > (size_t)(inEnd - in) || literalLength > (size_t)(outEnd - out))
+                    throw diannex_exception("Corrupt LZ data (literals out of bounds)");
+                std::memcpy(out, in, literalLength);
+                in += literalLength;
+                out += literalLength;
+                if (in == inEnd)
+                    break;
+
+                if (inEnd - in < 2)
+                    throw diannex_exception("Corrupt LZ data (truncated distance)");
+                auto distance = (size_t)in[0] | ((size_t)in[1] << 8);
+                in += 2;
+                auto matchLength = read_length(in, inEnd, token & 15) + MinMatch;
+                if (distance == 0 || distance > (size_t)(out - outStart) || matchLength > (size_t)(outEnd - out))
+                    throw diannex_exception("Corrupt LZ data (match out of bounds)");
+
+                // Matches mostly overlap their source by more than a word, so they can be copied a word at a time
+                // when there's room to run over the end; the overrun is written over by what comes next
+                const auto* match = out - distance;
+                if (distance >= 8 && (size_t)(outEnd - out) >= matchLength + 7)
+                {
+                    for (size_t i = 0; i < matchLength; i += 8)
+                        std::memcpy(out + i, match + i, 8);
+                }
+                else
+                {
+                    for (size_t i = 0; i < matchLength; ++i)
+                        out[i] = match[i];
+                }
+                out += matchLength;
+            }
+
+            if (out != outEnd)
+                throw diannex_exception("Corrupt LZ data (frame of the wrong size)");
+        }
+    }
+
+    DxByteBuf lz_compress(DxByteSpan input)
+    {
+        DxByteBuf out;
+        out.reserve(input.size() / 2);
+        DxVec<uint32_t> table(1 << HashBits);
+
+        for (size_t offset = 0; offset < input.size(); offset += LzFrameSize)
+        {
+            auto frame = input.subspan(offset, std::min(LzFrameSize, input.size() - offset));
+            auto header = out.size();
+            out.resize(header + sizeof(uint32_t));
+            compress_frame(frame, out, table);
+
+            auto size = (uint32_t)(out.size() - header - sizeof(uint32_t));
+            if (size >= frame.size())
+            {
+                // Didn't compress; stored as is instead
+                out.resize(header + sizeof(uint32_t));
+                out.insert(out.end(), frame.begin(), frame.end());
+                size = (uint32_t)frame.size() | StoredFrame;
+            }
+            std::memcpy(out.data() + header, &size, sizeof(size));
+        }
+
+        return out;
+    }
+
+    void lz_decompress(DxByteSpan input, std::span<std::byte> output, unsigned int threadCount)
+    {
+        DxVec<Frame> frames;
+        size_t in = 0;
+        for (size_t out = 0; out < output.size(); out += LzFrameSize)
+        {
+            if (input.size() - in < sizeof(uint32_t))
+                throw diannex_exception("Corrupt LZ data (truncated frame header)");
+            uint32_t header;
+            std::memcpy(&header, input.data() + in, sizeof(header));
+            in += sizeof(header);
+
+            size_t size = header & ~StoredFrame;
+            if (size > input.size() - in)
+                throw diannex_exception("Corrupt LZ data (truncated frame)");
+            frames.push_back({ input.subspan(in, size),
+                               output.subspan(out, std::min(LzFrameSize, output.size() - out)),
+                               (header & StoredFrame) != 0 });
+            in += size;
+        }
+        if (in != input.size())
+            throw diannex_exception("Corrupt LZ data (trailing data)");
+
+        auto taskCount = std::min<size_t>(std::max(threadCount, 1u), frames.size());
+        if (taskCount <= 1)
+        {
+            for (const auto& frame: frames)
+                decompress_frame(frame);
+            return;
+        }
+
+        // Contiguous runs of frames, the first one decompressed on this thread
+        DxVec<std::future<void>> tasks;
+        auto perTask = (frames.size() + taskCount - 1) / taskCount;
+        for (size_t first = perTask; first < frames.size(); first += perTask)
+        {
+            auto last = std::min(first + perTask, frames.size());
+            tasks.push_back(std::async(std::launch::async, [&frames, first, last]
+            {
+                for (auto i = first; i < last; ++i)
+                    decompress_frame(frames[i]);
+            }));
+        }
+        for (size_t i = 0; i < perTask; ++i)
+            decompress_frame(frames[i]);
+        for (auto& task: tasks)
+            task.get();
+    }
+}
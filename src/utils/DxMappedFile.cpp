@@ -0,0 +1,170 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "utils/DxMappedFile.hpp"
+
+#include "exceptions.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace diannex
+{
+    namespace
+    {
+        size_t page_size()
+        {
+            #ifdef _WIN32
+            static const size_t size = []
+            {
+                SYSTEM_INFO info;
+                GetSystemInfo(&info);
+                return (size_t)info.dwPageSize;
+            }();
+            #else
+            static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+            #endif
+            return size;
+        }
+
+        /** The whole pages overlapping `range`. */
+        std::pair<uintptr_t, size_t> page_range(DxByteSpan range)
+        {
+            auto pageSize = page_size();
+            auto begin = (uintptr_t)range.data() / pageSize * pageSize;
+            auto end = ((uintptr_t)range.data() + range.size() + pageSize - 1) / pageSize * pageSize;
+            return { begin, end - begin };
+        }
+    }
+
+    #ifdef _WIN32
+
+    DxMappedFile::DxMappedFile(const DxStrRef& filename)
+    {
+        auto file = CreateFileA(DxStr{ filename }.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw data_processing_exception(filename, "Could not open file");
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            throw data_processing_exception(filename, "Could not read file size");
+        }
+        m_size = (size_t)size.QuadPart;
+
+        // Mapping an empty file fails, and there is nothing to map anyway
+        if (m_size != 0)
+        {
+            m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping)
+                m_data = (const std::byte*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+        CloseHandle(file);
+
+        if (m_size != 0 && !m_data)
+        {
+            if (m_mapping)
+                CloseHandle(m_mapping);
+            throw data_processing_exception(filename, "Could not map file into memory");
+        }
+    }
+
+    DxMappedFile::~DxMappedFile()
+    {
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+    }
+
+    void DxMappedFile::prefetch(DxByteSpan range) const
+    {
+        auto [begin, size] = page_range(range);
+        WIN32_MEMORY_RANGE_ENTRY entry{ (void*)begin, size };
+        if (size != 0)
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+    }
+
+    void DxMappedFile::release(DxByteSpan range) const
+    {
+        // Unlocking pages that aren't locked takes them out of the working set
+        auto [begin, size] = page_range(range);
+        if (size != 0)
+            VirtualUnlock((void*)begin, size);
+    }
+
+    #else
+
+    DxMappedFile::DxMappedFile(const DxStrRef& filename)
+    {
+        auto fd = open(DxStr{ filename }.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            throw data_processing_exception(filename, "Could not open file");
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            throw data_processing_exception(filename, "Could not read file size");
+        }
+        m_size = (size_t)info.st_size;
+
+        // Mapping an empty file fails, and there is nothing to map anyway
+        if (m_size != 0)
+        {
+            auto data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED)
+                m_data = (const std::byte*)data;
+        }
+        close(fd);
+
+        if (m_size != 0 && !m_data)
+            throw data_processing_exception(filename, "Could not map file into memory");
+    }
+
+    DxMappedFile::~DxMappedFile()
+    {
+        if (m_data)
+            munmap((void*)m_data, m_size);
+    }
+
+    void DxMappedFile::prefetch(DxByteSpan range) const
+    {
+        auto [begin, size] = page_range(range);
+        if (size != 0)
+            madvise((void*)begin, size, MADV_WILLNEED);
+    }
+
+    void DxMappedFile::release(DxByteSpan range) const
+    {
+        // The mapping is shared and read-only, so the pages are only dropped, and read back from the file when used
+        auto [begin, size] = page_range(range);
+        if (size != 0)
+            madvise((void*)begin, size, MADV_DONTNEED);
+    }
+
+    #endif
+}
@@ -0,0 +1,228 @@
+/*======================================================================================================================
+ * Copyright © 2023 PeriBooty and Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *====================================================================================================================*/
+#include "utils/DxSharedImage.hpp"
+
+#include "exceptions.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace diannex
+{
+    namespace
+    {
+        constexpr char Magic[4] = { 'D', 'X', 'S', 'I' };
+
+        struct SegmentHeader
+        {
+            char magic[4];
+            // Set last, once the image is complete
+            uint32_t ready;
+            uint64_t size;
+        };
+
+        static_assert(sizeof(SegmentHeader) <= DxSharedImage::ImageOffset);
+
+        size_t segment_size(DxROSpan<DxByteSpan> parts)
+        {
+            size_t size = DxSharedImage::ImageOffset;
+            for (auto part: parts)
+                size += part.size();
+            return size;
+        }
+
+        void write_segment(std::byte* data, size_t size, DxROSpan<DxByteSpan> parts)
+        {
+            SegmentHeader header{};
+            std::memcpy(header.magic, Magic, sizeof(Magic));
+            header.size = size;
+            std::memcpy(data, &header, sizeof(header));
+
+            auto out = data + DxSharedImage::ImageOffset;
+            for (auto part: parts)
+            {
+                std::memcpy(out, part.data(), part.size());
+                out += part.size();
+            }
+            std::atomic_ref(((SegmentHeader*)data)->ready).store(1, std::memory_order_release);
+        }
+
+        /** Throws unless `data` is a complete segment of at most `size` bytes, returning its size. */
+        size_t check_segment(const std::byte* data, size_t size, const DxStrRef& name)
+        {
+            if (size < DxSharedImage::ImageOffset)
+                throw data_processing_exception(name, "Shared image hasn't been written yet");
+
+            // Only read, the mapping is read-only
+            auto& header = *const_cast<SegmentHeader*>((const SegmentHeader*)data);
+            if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+                throw data_processing_exception(name, "Not a Diannex shared image");
+            if (std::atomic_ref(header.ready).load(std::memory_order_acquire) != 1)
+                throw data_processing_exception(name, "Shared image hasn't been written yet");
+            if (header.size < DxSharedImage::ImageOffset || header.size > size)
+                throw data_processing_exception(name, "Shared image is truncated");
+            return (size_t)header.size;
+        }
+    }
+
+    #ifdef _WIN32
+
+    DxPtr<const DxSharedImage> DxSharedImage::create(const DxStrRef& name, DxROSpan<DxByteSpan> parts)
+    {
+        auto size = segment_size(parts);
+        auto mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32),
+                                          (DWORD)size, DxStr{ name }.c_str());
+        if (!mapping)
+            throw data_processing_exception(name, "Could not create shared image");
+        if (GetLastError() == ERROR_ALREADY_EXISTS)
+        {
+            CloseHandle(mapping);
+            throw data_processing_exception(name, "Shared image exists already");
+        }
+
+        auto data = (std::byte*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+        if (!data)
+        {
+            CloseHandle(mapping);
+            throw data_processing_exception(name, "Could not map shared image into memory");
+        }
+        write_segment(data, size, parts);
+        DWORD oldProtection;
+        VirtualProtect(data, size, PAGE_READONLY, &oldProtection);
+
+        DxPtr<DxSharedImage> image{ new DxSharedImage() };
+        image->m_data = data;
+        image->m_size = size;
+        image->m_mapping = mapping;
+        return image;
+    }
+
+    DxPtr<const DxSharedImage> DxSharedImage::open(const DxStrRef& name)
+    {
+        auto mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, DxStr{ name }.c_str());
+        if (!mapping)
+            throw data_processing_exception(name, "Could not open shared image");
+
+        DxPtr<DxSharedImage> image{ new DxSharedImage() };
+        image->m_mapping = mapping;
+        image->m_data = (const std::byte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!image->m_data)
+            throw data_processing_exception(name, "Could not map shared image into memory");
+
+        // Views are whole pages, so the size only comes from the header
+        MEMORY_BASIC_INFORMATION info{};
+        VirtualQuery(image->m_data, &info, sizeof(info));
+        image->m_size = check_segment(image->m_data, info.RegionSize, name);
+        return image;
+    }
+
+    bool DxSharedImage::remove(const DxStrRef&)
+    { return false; }
+
+    DxSharedImage::~DxSharedImage()
+    {
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+    }
+
+    #else
+
+    DxPtr<const DxSharedImage> DxSharedImage::create(const DxStrRef& name, DxROSpan<DxByteSpan> parts)
+    {
+        DxStr objectName{ name };
+        auto fd = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd == -1)
+        {
+            throw data_processing_exception(name, errno == EEXIST ? "Shared image exists already"
+                                                                  : "Could not create shared image");
+        }
+
+        auto size = segment_size(parts);
+        void* data = MAP_FAILED;
+        if (ftruncate(fd, (off_t)size) == 0)
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+        {
+            shm_unlink(objectName.c_str());
+            throw data_processing_exception(name, "Could not map shared image into memory");
+        }
+
+        write_segment((std::byte*)data, size, parts);
+        mprotect(data, size, PROT_READ);
+
+        DxPtr<DxSharedImage> image{ new DxSharedImage() };
+        image->m_data = (const std::byte*)data;
+        image->m_size = size;
+        return image;
+    }
+
+    DxPtr<const DxSharedImage> DxSharedImage::open(const DxStrRef& name)
+    {
+        auto fd = shm_open(DxStr{ name }.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd == -1)
+            throw data_processing_exception(name, "Could not open shared image");
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            throw data_processing_exception(name, "Could not read shared image size");
+        }
+
+        // Still empty while its creator is between creating and sizing it
+        auto size = (size_t)info.st_size;
+        void* data = size == 0 ? MAP_FAILED : mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (size == 0)
+            throw data_processing_exception(name, "Shared image hasn't been written yet");
+        if (data == MAP_FAILED)
+            throw data_processing_exception(name, "Could not map shared image into memory");
+
+        // Owned before checking, so that it's unmapped if that throws; segments are exactly as large as their image
+        DxPtr<DxSharedImage> image{ new DxSharedImage() };
+        image->m_data = (const std::byte*)data;
+        image->m_size = size;
+        check_segment(image->m_data, size, name);
+        return image;
+    }
+
+    bool DxSharedImage::remove(const DxStrRef& name)
+    { return shm_unlink(DxStr{ name }.c_str()) == 0; }
+
+    DxSharedImage::~DxSharedImage()
+    {
+        if (m_data)
+            munmap((void*)m_data, m_size);
+    }
+
+    #endif
+}
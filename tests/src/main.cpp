@@ -19,6 +19,22 @@
 #include "doctest.h"
 
 #include <diannex/DxInterpreter.hpp>
+#include <diannex/DxExplorer.hpp>
+#include <diannex/DxInstructions.hpp>
+#include <diannex/DxNameIndex.hpp>
+#include <diannex/utils/BinaryReader.hpp>
+#include <diannex/utils/DxLz.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace diannex;
 
@@ -52,6 +68,796 @@ private:
     std::unordered_map<std::string, DxValue> m_flags{};
 };
 
+struct CountingInstrumentation : DxNoInstrumentation
+{
+    static inline int instructions = 0;
+    static inline int calls = 0;
+    static inline int returns = 0;
+    static inline int externalCalls = 0;
+    static inline int texts = 0;
+
+    static void onInstruction(DxInterpreter&, int, DxOpcode)
+    { instructions++; }
+
+    static void onCall(DxInterpreter&, DxStrRef)
+    { calls++; }
+
+    static void onReturn(DxInterpreter&)
+    { returns++; }
+
+    static void onCallExt(DxInterpreter&, DxStrRef, const DxVec<DxValue>&)
+    { externalCalls++; }
+
+    static void onText(DxInterpreter&, const DxStr&)
+    { texts++; }
+};
+
+struct CountingResource : std::pmr::memory_resource
+{
+    size_t allocations = 0;
+    size_t live = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocations++;
+        live++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        live--;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    { return this == &other; }
+};
+
+TEST_CASE("String table indexes strings stored back to back")
+{
+    constexpr char arena[] = "first\0\0third\0unterminated";
+    auto bytes = std::as_bytes(std::span{ arena, sizeof(arena) - 1 });
+
+    DxStringTable table(bytes, 3);
+    REQUIRE_EQ(table.size(), 3);
+    REQUIRE_EQ(table[0], "first");
+    REQUIRE_EQ(table[1], "");
+    REQUIRE_EQ(table[2], "third");
+    REQUIRE_THROWS_AS((void)table.at(3), std::out_of_range);
+    REQUIRE_THROWS_AS(DxStringTable(bytes, 4), diannex_exception);
+}
+
+// Hands out the file a few bytes at a time, like a stream out of an archive would
+class TrickleReader : public BinaryReader
+{
+    DxByteBuf m_bytes;
+    size_t m_position{ 0 };
+public:
+    explicit TrickleReader(DxByteBuf bytes)
+        : m_bytes(std::move(bytes))
+    {}
+
+    void skip(size_t count) override
+    { m_position += count; }
+
+    void read_n(size_t count, void* val) override
+    {
+        if (count > m_bytes.size() - m_position)
+            throw diannex_exception("Unexpected end of stream");
+        for (auto* out = (std::byte*)val; count != 0;)
+        {
+            auto chunk = std::min<size_t>(count, 3);
+            std::memcpy(out, m_bytes.data() + m_position, chunk);
+            m_position += chunk;
+            out += chunk;
+            count -= chunk;
+        }
+    }
+};
+
+// A translation file replacing every line with its index, as "[index]", or "<prefix>[index]" for every other one
+DxByteBuf make_translation(uint32_t count, const DxStrRef& prefix = {}, bool indexed = false)
+{
+    DxVec<DxStr> lines;
+    for (uint32_t i = 0; i < count; ++i)
+        lines.push_back(DxFormat("{}[{}]", i % 2 == 0 ? DxStrRef{} : prefix, i));
+
+    DxByteBuf bytes{ std::byte{ 'D' }, std::byte{ 'X' }, std::byte{ 'T' }, std::byte{ indexed } };
+    auto write = [&bytes](uint32_t value)
+    {
+        bytes.resize(bytes.size() + sizeof(value));
+        std::memcpy(bytes.data() + bytes.size() - sizeof(value), &value, sizeof(value));
+    };
+
+    write(count);
+    if (indexed)
+    {
+        uint32_t offset = 0;
+        write(offset);
+        for (const auto& line: lines)
+            write(offset += (uint32_t)line.size() + 1);
+    }
+    for (const auto& line: lines)
+    {
+        for (char c: line)
+            bytes.push_back((std::byte)c);
+        bytes.push_back(std::byte{ 0 });
+    }
+    return bytes;
+}
+
+TEST_CASE("Data loads the same from a file, a mapping, memory or a reader")
+{
+    std::ifstream file("data/sample.dxb", std::ios::binary);
+    DxByteBuf bytes;
+    std::transform(std::istreambuf_iterator<char>(file), {}, std::back_inserter(bytes), [](char c)
+    { return (std::byte)c; });
+
+    auto read = DxData::fromFile("data/sample.dxb");
+    DxOpt<DxData> loaded;
+    SUBCASE("mapped")
+    { loaded = DxData::fromFile("data/sample.dxb", DxData::LoadMode::Map); }
+    SUBCASE("from memory")
+    { loaded = DxData::fromMemory(bytes); }
+    SUBCASE("through a reader")
+    { loaded = DxData::fromReader(std::make_shared<TrickleReader>(bytes)); }
+    SUBCASE("in the background")
+    { loaded = DxData::loadAsync(std::make_shared<TrickleReader>(bytes)).get(); }
+
+    REQUIRE(std::ranges::equal(read.instructions(), loaded->instructions()));
+    REQUIRE_EQ(read.sceneTable().size(), loaded->sceneTable().size());
+    REQUIRE_EQ(read.translationCount(), loaded->translationCount());
+    for (size_t i = 0; i < read.translationCount(); ++i)
+        REQUIRE_EQ(read.translation(i), loaded->translation(i));
+    REQUIRE(loaded->findScene("area0.intro"));
+    REQUIRE_EQ(loaded->definitions().size(), read.definitions().size());
+
+    REQUIRE_THROWS_AS(DxData::fromMemory(DxByteSpan{ bytes }.first(bytes.size() / 2), "half"),
+                      data_processing_exception);
+    REQUIRE_THROWS_AS(DxData::loadAsync("data/missing.dxb").get(), data_processing_exception);
+}
+
+TEST_CASE("LZ compressed binaries load like uncompressed ones")
+{
+    SUBCASE("codec round trip")
+    {
+        // Repetitive text over several frames, then noise that is stored as is
+        DxByteBuf input;
+        for (int i = 0; input.size() < 3 * LzFrameSize; ++i)
+        {
+            auto line = DxFormat("Line {} of the dialogue, said by character {}.\n", i, i % 7);
+            std::transform(line.begin(), line.end(), std::back_inserter(input), [](char c)
+            { return (std::byte)c; });
+        }
+        uint32_t state = 1;
+        for (int i = 0; i < 100000; ++i)
+            input.push_back((std::byte)((state = state * 1103515245 + 12345) >> 24));
+
+        auto compressed = lz_compress(input);
+        REQUIRE_LT(compressed.size(), input.size() / 2);
+        for (unsigned int threads: { 1u, 4u })
+        {
+            DxByteBuf output(input.size());
+            lz_decompress(compressed, output, threads);
+            REQUIRE(output == input);
+        }
+
+        DxByteBuf output(input.size());
+        REQUIRE_THROWS_AS(lz_decompress(DxByteSpan{ compressed }.first(compressed.size() - 1), output),
+                          diannex_exception);
+        compressed[2] = std::byte{ 0x7F }; // The first frame now runs past the end
+        REQUIRE_THROWS_AS(lz_decompress(compressed, output), diannex_exception);
+    }
+
+    SUBCASE("compiled with --fast")
+    {
+        auto raw = DxData::fromFile("data/main.dxb");
+        for (auto mode: { DxData::LoadMode::Read, DxData::LoadMode::Map })
+        {
+            auto lz = DxData::fromFile("data/main_lz.dxb", mode);
+            REQUIRE(std::ranges::equal(raw.instructions(), lz.instructions()));
+            REQUIRE_EQ(raw.sceneTable().size(), lz.sceneTable().size());
+            REQUIRE_EQ(raw.translationCount(), lz.translationCount());
+            for (size_t i = 0; i < raw.translationCount(); ++i)
+                REQUIRE_EQ(raw.translation(i), lz.translation(i));
+            REQUIRE(lz.findScene("area0.intro"));
+        }
+    }
+}
+
+TEST_CASE("Binaries with a section directory load like version 4 ones")
+{
+    auto v4 = DxData::fromFile("data/main.dxb");
+    REQUIRE(v4.sections().empty());
+
+    for (auto mode: { DxData::LoadMode::Read, DxData::LoadMode::Map })
+    {
+        auto v5 = DxData::fromFile("data/main_v5.dxb", mode);
+        REQUIRE_EQ(v5.sections().size(), 8);
+        REQUIRE(std::ranges::equal(v4.instructions(), v5.instructions()));
+        REQUIRE_EQ(v4.sceneTable().size(), v5.sceneTable().size());
+        REQUIRE_EQ(v4.definitions().size(), v5.definitions().size());
+        REQUIRE_EQ(v4.translationCount(), v5.translationCount());
+        for (size_t i = 0; i < v4.translationCount(); ++i)
+            REQUIRE_EQ(v4.translation(i), v5.translation(i));
+        REQUIRE(v5.findScene("area0.intro"));
+    }
+
+    auto bytecode = DxData::readSection("data/main_v5.dxb", DxSectionType::Bytecode);
+    REQUIRE(std::ranges::equal(bytecode, v4.instructions()));
+    REQUIRE_THROWS_AS(DxData::readSection("data/main_v5.dxb", (DxSectionType)99), data_processing_exception);
+    REQUIRE_THROWS_AS(DxData::readSection("data/main.dxb", DxSectionType::Bytecode), data_processing_exception);
+}
+
+TEST_CASE("Blocks decode the same on threads, where corrupt ones throw")
+{
+    auto read_bytes = [](const char* filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        DxByteBuf bytes;
+        std::transform(std::istreambuf_iterator<char>(file), {}, std::back_inserter(bytes), [](char c)
+        { return (std::byte)c; });
+        return bytes;
+    };
+
+    auto threshold = DxData::parallelLoadThreshold();
+    REQUIRE_EQ(threshold, 1024 * 1024);
+
+    for (auto filename: { "data/main.dxb", "data/main_lz.dxb", "data/main_v5.dxb", "data/main_names.dxb" })
+    {
+        auto sequential = DxData::fromFile(filename);
+        DxData::parallelLoadThreshold(0);
+        auto threaded = DxData::fromFile(filename);
+        DxData::parallelLoadThreshold(threshold);
+
+        REQUIRE(std::ranges::equal(sequential.instructions(), threaded.instructions()));
+        REQUIRE(std::ranges::equal(sequential.sceneTable().names(), threaded.sceneTable().names()));
+        REQUIRE(std::ranges::equal(sequential.functionTable().names(), threaded.functionTable().names()));
+        REQUIRE(std::ranges::equal(sequential.definitionNames(), threaded.definitionNames()));
+        REQUIRE_EQ(sequential.translationCount(), threaded.translationCount());
+        for (size_t i = 0; i < sequential.translationCount(); ++i)
+            REQUIRE_EQ(sequential.translation(i), threaded.translation(i));
+    }
+
+    // One more function or definition than the block holds, so that decoding it runs off the end of the block
+    auto bytes = read_bytes("data/main_v5.dxb");
+    auto corrupt = [&bytes](DxSectionType type)
+    {
+        constexpr size_t payload = 9;
+        uint32_t count;
+        std::memcpy(&count, bytes.data() + payload, sizeof(count));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t section[3];
+            std::memcpy(section, bytes.data() + payload + 4 + i * sizeof(section), sizeof(section));
+            if (section[0] != (uint32_t)type)
+                continue;
+
+            auto corrupted = bytes;
+            auto* blockCount = corrupted.data() + payload + section[1];
+            uint32_t entries;
+            std::memcpy(&entries, blockCount, sizeof(entries));
+            entries++;
+            std::memcpy(blockCount, &entries, sizeof(entries));
+            return corrupted;
+        }
+        FAIL("No such section");
+        return bytes;
+    };
+
+    for (auto type: { DxSectionType::Functions, DxSectionType::Definitions })
+    {
+        auto corrupted = corrupt(type);
+        for (size_t parallel: { threshold, size_t{ 0 } })
+        {
+            DxData::parallelLoadThreshold(parallel);
+            REQUIRE_THROWS_AS(DxData::fromMemory(corrupted, "corrupt"), diannex_exception);
+        }
+        DxData::parallelLoadThreshold(threshold);
+    }
+}
+
+TEST_CASE("Name index maps every name to its position")
+{
+    DxVec<DxStr> storage;
+    for (int i = 0; i < 1000; ++i)
+        storage.push_back(DxFormat("ns{}.name{}", i % 7, i));
+    DxVec<DxStrRef> names(storage.begin(), storage.end());
+
+    DxByteBuf bytes;
+    DxNameIndex::build(names, bytes);
+    DxNameIndex::build({}, bytes);
+    DxByteSpan span = bytes;
+    auto index = DxNameIndex::view(span);
+    auto empty = DxNameIndex::view(span);
+    REQUIRE(span.empty());
+
+    REQUIRE_EQ(index.size(), names.size());
+    for (size_t i = 0; i < names.size(); ++i)
+        REQUIRE_EQ(index.find(names[i]), i);
+    // Names that aren't there still lead somewhere (or nowhere), it's up to the caller to compare
+    auto miss = index.find("ns0.missing");
+    REQUIRE((!miss || *miss < names.size()));
+    REQUIRE(empty.empty());
+    REQUIRE_FALSE(empty.find("ns0.name0"));
+
+    names.push_back(names.front());
+    REQUIRE_THROWS_AS(DxNameIndex::build(names, bytes), diannex_exception);
+}
+
+TEST_CASE("Names resolve the same with or without a name index")
+{
+    auto v4 = DxData::fromFile("data/main.dxb");
+    REQUIRE_FALSE(v4.hasNameIndex());
+
+    for (auto mode: { DxData::LoadMode::Read, DxData::LoadMode::Map })
+    {
+        auto indexed = DxData::fromFile("data/main_names.dxb", mode);
+        REQUIRE(indexed.hasNameIndex());
+
+        for (auto name: v4.sceneTable().names())
+            REQUIRE_EQ(indexed.sceneTable().name(*indexed.findScene(name)), name);
+        for (auto name: v4.functionTable().names())
+            REQUIRE_EQ(indexed.functionTable().name(*indexed.findFunction(name)), name);
+        REQUIRE(std::ranges::equal(v4.definitionNames(), indexed.definitionNames()));
+        for (auto name: v4.definitionNames())
+        {
+            REQUIRE_EQ(indexed.findDefinition(name), v4.findDefinition(name));
+            REQUIRE_EQ(indexed.definition(name).codeOffset == -1, v4.definition(name).codeOffset == -1);
+        }
+
+        for (const auto* data: { &v4, &indexed })
+        {
+            REQUIRE_FALSE(data->findScene("area0.missing"));
+            REQUIRE_FALSE(data->findFunction("area0.missing"));
+            REQUIRE_FALSE(data->findDefinition("menu.missing"));
+            REQUIRE_THROWS_AS((void)data->definition("menu.missing"), diannex_exception);
+        }
+    }
+
+    DxInterpreter interpreter(DxData::fromFile("data/main_names.dxb"));
+    DxInterpreter reference(DxData::fromFile("data/main.dxb"));
+    REQUIRE_EQ(interpreter.definition("menu.button_quit"), "Quit");
+    for (auto name: v4.definitionNames())
+        REQUIRE_EQ(interpreter.definition(name), reference.definition(name));
+}
+
+#ifndef _WIN32
+TEST_CASE("Shared images are decoded once and used in place by every process")
+{
+    auto segment = DxFormat("/libdnxpp-tests-{}", getpid());
+    DxData::removeSharedImage(segment);
+    auto reference = DxData::fromFile("data/main_names.dxb");
+    auto same = [&reference](const DxData& data)
+    {
+        return std::ranges::equal(reference.instructions(), data.instructions()) &&
+               std::ranges::equal(reference.sceneTable().names(), data.sceneTable().names()) &&
+               std::ranges::equal(reference.definitionNames(), data.definitionNames()) &&
+               reference.translationCount() == data.translationCount() &&
+               reference.translation(reference.translationCount() - 1) ==
+               data.translation(data.translationCount() - 1) &&
+               reference.string(0) == data.string(0) &&
+               data.findScene("area0.intro");
+    };
+
+    // Uncompressed and version 5, or compressed and version 4
+    for (auto filename: { "data/main_names.dxb", "data/main_lz.dxb" })
+    {
+        auto published = DxData::publishSharedImage(filename, segment);
+        REQUIRE(same(published));
+        REQUIRE_THROWS_AS(DxData::publishSharedImage(filename, segment), data_processing_exception);
+
+        auto attached = DxData::fromSharedImage(segment);
+        REQUIRE(same(attached));
+        REQUIRE_NE(attached.instructions().data(), published.instructions().data());
+
+        auto pid = fork();
+        if (pid == 0)
+        {
+            bool ok = false;
+            try
+            {
+                ok = same(DxData::fromSharedImage(segment));
+            }
+            catch (...)
+            {}
+            _exit(ok ? 0 : 1);
+        }
+        int status = -1;
+        REQUIRE_EQ(waitpid(pid, &status, 0), pid);
+        REQUIRE(WIFEXITED(status));
+        REQUIRE_EQ(WEXITSTATUS(status), 0);
+
+        // Mappings outlive the segment's name
+        REQUIRE(DxData::removeSharedImage(segment));
+        REQUIRE_FALSE(DxData::removeSharedImage(segment));
+        REQUIRE_THROWS_AS(DxData::fromSharedImage(segment), data_processing_exception);
+        REQUIRE(same(attached));
+    }
+}
+#endif
+
+TEST_CASE("Translations load from memory or a reader")
+{
+    auto data = DxData::fromFile("data/sample.dxb");
+    auto count = (uint32_t)data.translationCount();
+    auto bytes = make_translation(count);
+
+    SUBCASE("from memory")
+    { data.loadTranslation(bytes); }
+    SUBCASE("through a reader")
+    {
+        TrickleReader reader(bytes);
+        data.loadTranslation(reader);
+    }
+
+    REQUIRE_EQ(data.translationCount(), count);
+    REQUIRE_EQ(data.translation(count - 1), DxFormat("[{}]", count - 1));
+
+    TrickleReader truncated(DxByteBuf(bytes.begin(), bytes.end() - 1));
+    REQUIRE_THROWS_AS(data.loadTranslation(truncated), data_processing_exception);
+}
+
+TEST_CASE("Indexed translations are used in place")
+{
+    auto data = DxData::fromFile("data/sample.dxb");
+    auto count = (uint32_t)data.translationCount();
+    auto bytes = make_translation(count, "indexed", true);
+
+    SUBCASE("from memory")
+    { data.loadTranslation(bytes); }
+    SUBCASE("through a reader")
+    {
+        TrickleReader reader(bytes);
+        data.loadTranslation(reader);
+    }
+    SUBCASE("mapped")
+    {
+        auto path = (std::filesystem::temp_directory_path() / "dx_tests_indexed.dxt").string();
+        std::ofstream(path, std::ios::binary).write((const char*)bytes.data(), (std::streamsize)bytes.size());
+        data.loadTranslationFile(path, DxData::LoadMode::Map);
+        std::filesystem::remove(path);
+    }
+
+    REQUIRE_EQ(data.translationCount(), count);
+    REQUIRE_EQ(data.translation(0), "[0]");
+    REQUIRE_EQ(data.translation(count - 1), DxFormat("{}[{}]", (count - 1) % 2 == 0 ? "" : "indexed", count - 1));
+
+    // A broken index is only noticed once the broken string is looked up
+    auto broken = bytes;
+    uint32_t pastTheEnd = 0xffff;
+    std::memcpy(broken.data() + 8 + 4 * count, &pastTheEnd, sizeof(pastTheEnd));
+    data.loadTranslation(broken);
+    REQUIRE_EQ(data.translation(0), "[0]");
+    REQUIRE_THROWS_AS((void)data.translation(count - 1), diannex_exception);
+}
+
+TEST_CASE("Translations are swapped in from the background without disturbing readers")
+{
+    DxInterpreter interpreter(DxData::fromFile("data/sample.dxb"));
+    DxVec<DxStr> lines;
+    interpreter.textHandler([&](auto text)
+                            { lines.push_back(std::move(text)); });
+    interpreter.choiceHandler([](auto)
+                              {});
+    interpreter.registerFunction("getPlayerName", []
+    { return "Player"s; });
+
+    auto before = interpreter.data().language();
+    DxStr firstLine{ before->translation(0) };
+
+    auto load = interpreter.data().loadTranslationAsync(
+        std::make_shared<TrickleReader>(make_translation((uint32_t)before->translationCount())));
+    REQUIRE_NOTHROW(load.get());
+
+    // Whoever held on to the old language still has it, everyone else gets the new one
+    REQUIRE_EQ(before->translation(0), firstLine);
+    REQUIRE_FALSE(interpreter.data().isCurrentLanguage(*before));
+    REQUIRE_EQ(interpreter.data().translation(0), "[0]");
+    REQUIRE_NE(interpreter.data().cacheID(), before->id());
+
+    interpreter.runScene("area0.intro");
+    REQUIRE_FALSE(lines.empty());
+    for (const auto& line: lines)
+        REQUIRE(line.starts_with('['));
+
+    auto failed = interpreter.data().loadTranslationAsync("data/missing.dxt");
+    REQUIRE_THROWS_AS(failed.get(), data_processing_exception);
+    REQUIRE_EQ(interpreter.data().translation(0), "[0]");
+}
+
+TEST_CASE("Resident languages share their text and are selected per interpreter")
+{
+    auto data = DxData::fromFile("data/sample.dxb");
+    auto count = (uint32_t)data.translationCount();
+    data.loadLanguage("fr", make_translation(count, "fr"));
+    data.loadLanguage("de", make_translation(count, "de"));
+    REQUIRE_EQ(data.residentLanguages(), DxVec<DxStr>{ "de", "fr" });
+    REQUIRE_THROWS_AS((void)data.language("es"), diannex_exception);
+    REQUIRE_THROWS_AS(data.loadLanguage("es", make_translation(count + 1)), data_processing_exception);
+
+    // Lines the languages have in common are the same string, those they don't are their own
+    auto fr = data.language("fr");
+    auto de = data.language("de");
+    REQUIRE_EQ(fr->translation(0), "[0]");
+    REQUIRE_EQ(fr->translation(0).data(), de->translation(0).data());
+    REQUIRE_EQ(fr->translation(1), "fr[1]");
+    REQUIRE_EQ(de->translation(1), "de[1]");
+
+    DxInterpreter interpreter(std::move(data));
+    DxVec<DxStr> lines;
+    interpreter.textHandler([&](auto text)
+                            { lines.push_back(std::move(text)); });
+    interpreter.choiceHandler([](auto)
+                              {});
+    interpreter.registerFunction("getPlayerName", []
+    { return "Player"s; });
+    REQUIRE_THROWS_AS(interpreter.language("es"), diannex_exception);
+
+    interpreter.language("de");
+    auto german = interpreter.fork();
+    interpreter.language({});
+    interpreter.runScene("area0.intro");
+    REQUIRE_FALSE(lines.empty());
+    REQUIRE_FALSE(lines.front().starts_with('['));
+
+    lines.clear();
+    german.textHandler([&](auto text)
+                       { lines.push_back(std::move(text)); });
+    german.runScene("area0.intro");
+    REQUIRE_FALSE(lines.empty());
+    for (const auto& line: lines)
+        REQUIRE((line.starts_with('[') || line.starts_with("de[")));
+}
+
+TEST_CASE("Reloaded data is switched to once the running scene ends")
+{
+    auto load = [](const DxStrRef& prefix)
+    {
+        auto data = DxData::fromFile("data/sample.dxb");
+        data.loadLanguage("de", make_translation((uint32_t)data.translationCount(), prefix));
+        return data;
+    };
+
+    DxInterpreter interpreter(load("old"));
+    DxVec<DxStr> lines;
+    int ended = 0;
+    int points = 0;
+    FlagStore flagStore;
+    interpreter.textHandler([&](auto text)
+                            { lines.push_back(std::move(text)); });
+    interpreter.choiceHandler([](auto)
+                              {});
+    interpreter.endSceneHandler([&](auto)
+                                { ended++; });
+    interpreter.registerFunctor<FlagStore::getter>("getFlag", flagStore);
+    interpreter.registerFunctor<FlagStore::setter>("setFlag", flagStore);
+    interpreter.registerFunction("awardPoints", [&points](int p)
+    { points += p; });
+    interpreter.registerFunction("getPlayerName", []
+    { return "Player"s; });
+    interpreter.language("de");
+
+    auto finish = [](DxInterpreter& target)
+    {
+        while (target.state() != DxInterpreter::State::Inactive)
+        {
+            if (target.state() == DxInterpreter::State::InChoice)
+                target.selectChoice(0);
+            else
+                target.resumeScene();
+        }
+    };
+    auto any_starts_with = [&lines](const DxStrRef& prefix)
+    {
+        return std::any_of(lines.begin(), lines.end(), [&](const auto& line)
+        { return line.starts_with(prefix); });
+    };
+
+    interpreter.runScene("area0.intro");
+    REQUIRE_EQ(interpreter.state(), DxInterpreter::State::InText);
+
+    const auto* original = &interpreter.data();
+    REQUIRE_FALSE(interpreter.reload(load("new")));
+    REQUIRE(interpreter.reloadPending());
+    REQUIRE_EQ(&interpreter.data(), original);
+    auto fork = interpreter.fork();
+
+    // The scene finishes on the data it started with, the next one runs on the new data
+    finish(interpreter);
+    REQUIRE_EQ(ended, 1);
+    REQUIRE(any_starts_with("old["));
+    REQUIRE_FALSE(any_starts_with("new["));
+    REQUIRE_FALSE(interpreter.reloadPending());
+    REQUIRE_NE(&interpreter.data(), original);
+
+    lines.clear();
+    interpreter.runScene("area0.intro");
+    finish(interpreter);
+    REQUIRE_EQ(ended, 2);
+    REQUIRE_EQ(points, 2);
+    REQUIRE(any_starts_with("new["));
+    REQUIRE_FALSE(any_starts_with("old["));
+
+    // The fork keeps the old data alive until its own scene ends
+    REQUIRE(fork.reloadPending());
+    REQUIRE_EQ(&fork.data(), original);
+    lines.clear();
+    finish(fork);
+    REQUIRE_FALSE(fork.reloadPending());
+    REQUIRE(any_starts_with("old["));
+
+    REQUIRE(interpreter.reload(load("newer")));
+    REQUIRE_THROWS_AS(interpreter.reload(DxData::fromFile("data/sample.dxb")), diannex_exception);
+    REQUIRE_FALSE(interpreter.reloadPending());
+    lines.clear();
+    interpreter.runScene("area0.intro");
+    REQUIRE_EQ(interpreter.state(), DxInterpreter::State::InText);
+    interpreter.resumeScene();
+    REQUIRE(any_starts_with("newer["));
+}
+
+TEST_CASE("Reloaded data shared by several interpreters sets up flags for each")
+{
+    DxVec<DxMap<DxStr, DxValue>> stores(2);
+    DxVec<DxInterpreter> interpreters;
+    for (auto& store: stores)
+    {
+        auto& interpreter = interpreters.emplace_back(DxData::fromFile("data/flags.dxb"));
+        interpreter.flagSetHandler([&store](DxStrRef name, DxValue value)
+                                   { store.insert_or_assign(DxStr{ name }, std::move(value)); });
+        interpreter.flagGetHandler([&store](DxStrRef name)
+                                   {
+                                       auto it = store.find(DxStr{ name });
+                                       return it != store.end() ? it->second : DxValue{};
+                                   });
+        REQUIRE(interpreter.initializeFlags());
+        REQUIRE_EQ(store.size(), 3);
+    }
+
+    // Flags a new version adds get their defaults in every interpreter switching to it, not just the first one
+    auto next = std::make_shared<DxData>(DxData::fromFile("data/flags.dxb"));
+    for (size_t i = 0; i < interpreters.size(); ++i)
+    {
+        stores[i].clear();
+        REQUIRE(interpreters[i].reload(next));
+        REQUIRE_EQ(&interpreters[i].data(), next.get());
+        REQUIRE_EQ(stores[i].size(), 3);
+        REQUIRE_EQ(stores[i].at("flagged.greet_greeted").safe_get<DxValueType::Integer>(), 5);
+    }
+}
+
+TEST_CASE("Scene stacks and locals are allocated from the interpreter's memory resource")
+{
+    CountingResource upstream;
+    std::pmr::monotonic_buffer_resource arena{ &upstream };
+    FlagStore flagStore;
+
+    DxInterpreter interpreter(DxData::fromFile("data/sample.dxb"));
+    interpreter.textHandler([](auto)
+                            {});
+    interpreter.choiceHandler([](auto)
+                              {});
+    interpreter.registerFunctor<FlagStore::getter>("getFlag", flagStore);
+    interpreter.registerFunctor<FlagStore::setter>("setFlag", flagStore);
+    interpreter.registerFunction("awardPoints", [](int)
+    {});
+    interpreter.registerFunction("getPlayerName", []
+    { return "Player"s; });
+
+    auto finish = [&interpreter]
+    {
+        while (interpreter.state() != DxInterpreter::State::Inactive)
+        {
+            if (interpreter.state() == DxInterpreter::State::InChoice)
+                interpreter.selectChoice(0);
+            else
+                interpreter.resumeScene();
+        }
+    };
+
+    SUBCASE("released in one go when the scene ends")
+    {
+        int ended = 0;
+        interpreter.endSceneHandler([&](auto)
+                                    {
+                                        ended++;
+                                        arena.release();
+                                    });
+        interpreter.memoryResource(&arena);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            interpreter.runScene("area0.intro");
+            REQUIRE_GT(upstream.allocations, 0);
+            REQUIRE_THROWS_AS(interpreter.memoryResource(nullptr), diannex_exception);
+            finish();
+            REQUIRE_EQ(ended, i + 1);
+            REQUIRE_EQ(upstream.live, 0);
+        }
+    }
+
+    SUBCASE("let go of by the time the scene ends")
+    {
+        interpreter.memoryResource(&upstream);
+        interpreter.runScene("area0.intro");
+        REQUIRE_GT(upstream.live, 0);
+        finish();
+        REQUIRE_EQ(upstream.live, 0);
+        REQUIRE_EQ(flagStore("sample").safe_get<DxValueType::Integer>(), 1);
+
+        interpreter.memoryResource(nullptr);
+        REQUIRE_EQ(interpreter.memoryResource(), std::pmr::get_default_resource());
+    }
+}
+
+TEST_CASE("Scene values are allocated from the interpreter's memory resource")
+{
+    // Nothing falls back to the global heap (the arena has no upstream), and what handlers got is still intact after the
+    // arena is scribbled over
+    std::array<char, 64 * 1024> buffer{};
+    std::pmr::monotonic_buffer_resource arena{ buffer.data(), buffer.size(), std::pmr::null_memory_resource() };
+    auto in_arena = [&buffer](const DxStrRef& text)
+    { return DxStrRef{ buffer.data(), buffer.size() }.find(text) != DxStrRef::npos; };
+
+    DxInterpreter interpreter(DxData::fromFile("data/values.dxb"));
+    DxVec<DxStr> lines;
+    DxVec<DxValue> kept;
+    interpreter.textHandler([&lines](auto text)
+                            { lines.push_back(std::move(text)); });
+    interpreter.registerFunction("keep", [&kept](const DxValue& greeting, const DxValue& joined)
+    {
+        kept.push_back(greeting);
+        kept.push_back(joined);
+    });
+
+    bool inArena = false;
+    interpreter.endSceneHandler([&](auto)
+                                {
+                                    // Text pushed, joined and interpolated by the scene, and the array it built
+                                    inArena = in_arena("A greeting that is too long for the small string buffer") &&
+                                              in_arena("A second entry that is also far too long to fit, with a") &&
+                                              in_arena("small string buffer, then 3");
+                                    arena.release();
+                                    buffer.fill('#');
+                                });
+    interpreter.memoryResource(&arena);
+
+    interpreter.runScene("values.mix");
+    while (interpreter.state() != DxInterpreter::State::Inactive)
+        interpreter.resumeScene();
+
+    REQUIRE(inArena);
+    REQUIRE_EQ(lines, DxVec<DxStr>{ "A greeting that is too long for the small string buffer, then 3" });
+    REQUIRE_EQ(kept.size(), 2);
+    REQUIRE_EQ(kept[0].safe_get<DxValueType::String>(), "A greeting that is too long for the small string buffer");
+    REQUIRE_EQ(kept[1].safe_get<DxValueType::String>(),
+               "A second entry that is also far too long to fit, with a long suffix appended to it");
+}
+
+TEST_CASE("Mapped data pages scenes in within a budget")
+{
+    REQUIRE_THROWS_AS(DxData::fromFile("data/main.dxb").residencyBudget(1), diannex_exception);
+
+    auto data = DxData::fromFile("data/main.dxb", DxData::LoadMode::Map);
+    data.residencyBudget(1);
+    const auto* pager = data.pager();
+    REQUIRE(pager);
+    REQUIRE_EQ(pager->residentChunks(), 0);
+
+    DxInterpreter interpreter(std::move(data));
+    interpreter.textHandler([](auto)
+                            {});
+    interpreter.registerFunction("getPlayerName", []
+    { return "Player"s; });
+
+    REQUIRE_NOTHROW(interpreter.runScene("area0.intro"));
+    REQUIRE_EQ(pager->residentChunks(), 1);
+    REQUIRE_GT(pager->residentBytes(), 0);
+}
+
 TEST_CASE("Interpreter can run sample scene")
 {
     int points = 0;
@@ -127,4 +933,322 @@ TEST_CASE("Interpreter can run sample scene")
         REQUIRE_NOTHROW(interpreter.resumeScene());
         REQUIRE(sceneEnded);
     }
-}
\ No newline at end of file
+
+    SUBCASE("when started by handle")
+    {
+        auto intro = interpreter.sceneId("area0.intro");
+        REQUIRE_NOTHROW(interpreter.runScene(intro));
+        REQUIRE_EQ(currentText, "Welcome to the test introduction scene!");
+        REQUIRE_THROWS_AS((void)interpreter.sceneId("area0.missing"), diannex_exception);
+    }
+
+    SUBCASE("when stepped with an instruction budget")
+    {
+        REQUIRE_NOTHROW(interpreter.startScene("area0.intro"));
+        REQUIRE_EQ(interpreter.state(), DxInterpreter::State::Suspended);
+        REQUIRE(currentText.empty());
+
+        int slices = 0;
+        while (interpreter.step(2) == DxInterpreter::State::Suspended)
+            slices++;
+        REQUIRE_GT(slices, 0);
+        REQUIRE_EQ(interpreter.state(), DxInterpreter::State::InText);
+        REQUIRE_EQ(currentText, "Welcome to the test introduction scene!");
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        REQUIRE_EQ(interpreter.runFor(deadline), DxInterpreter::State::InText);
+        REQUIRE_EQ(currentText, "One quick thing I have to ask before you begin...");
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_EQ(interpreter.state(), DxInterpreter::State::InChoice);
+
+        REQUIRE_NOTHROW(interpreter.selectChoiceDeferred(0));
+        REQUIRE_EQ(interpreter.state(), DxInterpreter::State::Suspended);
+        REQUIRE_EQ(interpreter.step(1000), DxInterpreter::State::InText);
+        REQUIRE_EQ(currentText, "That is correct.");
+    }
+
+    #ifdef DIANNEX_PROFILER
+    SUBCASE("with the profiler enabled")
+    {
+        interpreter.profiler().enable();
+        REQUIRE_NOTHROW(interpreter.runScene("area0.intro"));
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_NOTHROW(interpreter.selectChoice(0));
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+
+        const auto& profiler = interpreter.profiler();
+        REQUIRE_GT(profiler.opcodes()[(size_t)DxOpcode::textrun].count, 0);
+        REQUIRE_EQ(profiler.natives().at("awardPoints").calls, 1);
+        REQUIRE_EQ(profiler.frames().at(0).name, "area0.intro");
+        REQUIRE_NE(profiler.toJson().find("\"opcode\": \"textrun\""), std::string::npos);
+        REQUIRE_EQ(profiler.toCollapsedStacks().rfind("area0.intro ", 0), 0);
+    }
+    #endif
+
+    SUBCASE("with an instrumentation policy")
+    {
+        int textCount = 0;
+        interpreter.textHandler([&textCount](auto)
+                                { textCount++; });
+
+        REQUIRE_NOTHROW(interpreter.runScene<CountingInstrumentation>("area0.intro"));
+        while (!sceneEnded)
+        {
+            if (interpreter.state() == DxInterpreter::State::InChoice)
+                REQUIRE_NOTHROW(interpreter.selectChoice<CountingInstrumentation>(0));
+            else
+                REQUIRE_NOTHROW(interpreter.resumeScene<CountingInstrumentation>());
+        }
+
+        REQUIRE_GT(CountingInstrumentation::instructions, 0);
+        REQUIRE_EQ(CountingInstrumentation::calls, 5);
+        REQUIRE_EQ(CountingInstrumentation::returns, 5);
+        REQUIRE_GT(CountingInstrumentation::externalCalls, 0);
+        REQUIRE_EQ(CountingInstrumentation::texts, textCount);
+    }
+
+    SUBCASE("when forked at a choice")
+    {
+        REQUIRE_NOTHROW(interpreter.runScene("area0.intro"));
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_EQ(choices.size(), 2);
+
+        auto fork = interpreter.fork();
+        REQUIRE_NOTHROW(fork.selectChoice(1));
+        REQUIRE_EQ(currentText, "Hm... I don't believe that's correct.");
+        REQUIRE_NOTHROW(fork.resumeScene());
+        REQUIRE_EQ(points, 5);
+
+        REQUIRE_NOTHROW(interpreter.selectChoice(0));
+        REQUIRE_EQ(currentText, "That is correct.");
+        REQUIRE_NOTHROW(interpreter.resumeScene());
+        REQUIRE_EQ(points, 6);
+        REQUIRE_EQ(currentText, "Either way, it was nice meeting you, Player.");
+    }
+}
+
+TEST_CASE("Interpreter sets up flags for itself")
+{
+    DxVec<DxStr> lines;
+    auto run = [&lines](DxInterpreter& interpreter)
+    {
+        lines.clear();
+        interpreter.runScene("flagged.visit");
+        while (interpreter.state() != DxInterpreter::State::Inactive)
+            interpreter.resumeScene();
+    };
+    auto use_store = [](DxInterpreter& interpreter, DxMap<DxStr, DxValue>& store)
+    {
+        interpreter.flagSetHandler([&store](DxStrRef name, DxValue value)
+                                   { store.insert_or_assign(DxStr{ name }, std::move(value)); });
+        interpreter.flagGetHandler([&store](DxStrRef name)
+                                   {
+                                       auto it = store.find(DxStr{ name });
+                                       return it != store.end() ? it->second : DxValue{};
+                                   });
+    };
+
+    SUBCASE("with the default handlers")
+    {
+        for (bool eager: { true, false })
+        {
+            DxInterpreter interpreter(DxData::fromFile("data/flags.dxb"));
+            interpreter.textHandler([&lines](auto text)
+                                    { lines.push_back(std::move(text)); });
+            if (eager)
+                REQUIRE(interpreter.initializeFlags());
+
+            REQUIRE_NOTHROW(run(interpreter));
+            REQUIRE_EQ(lines, DxVec<DxStr>{ "First visit", "Greeted" });
+            REQUIRE_NOTHROW(run(interpreter));
+            REQUIRE_EQ(lines, DxVec<DxStr>{ "Visited before", "Greeted" });
+        }
+    }
+
+    SUBCASE("in default stores of its own")
+    {
+        DxInterpreter first(DxData::fromFile("data/flags.dxb"));
+        DxInterpreter second(DxData::fromFile("data/flags.dxb"));
+        for (auto* interpreter: { &first, &second })
+            interpreter->textHandler([&lines](auto text)
+                                     { lines.push_back(std::move(text)); });
+        auto fork = first.fork();
+
+        run(first);
+        REQUIRE_EQ(lines.front(), "First visit");
+        run(second);
+        REQUIRE_EQ(lines.front(), "First visit");
+
+        // A fork starts from a copy of the store, so it neither sees nor changes what the original sets afterwards
+        run(fork);
+        REQUIRE_EQ(lines.front(), "First visit");
+        run(first);
+        REQUIRE_EQ(lines.front(), "Visited before");
+
+        auto later = first.fork();
+        run(later);
+        REQUIRE_EQ(lines.front(), "Visited before");
+    }
+
+    SUBCASE("separately from its forks")
+    {
+        DxInterpreter interpreter(DxData::fromFile("data/flags.dxb"));
+        interpreter.textHandler([&lines](auto text)
+                                { lines.push_back(std::move(text)); });
+        DxMap<DxStr, DxValue> flags, forkFlags;
+        use_store(interpreter, flags);
+        auto fork = interpreter.fork();
+        use_store(fork, forkFlags);
+
+        run(interpreter);
+        REQUIRE_EQ(lines, DxVec<DxStr>{ "First visit", "Greeted" });
+        REQUIRE_EQ(flags.size(), 3);
+        REQUIRE_EQ(flags.at("flagged.visit_visits").safe_get<DxValueType::Integer>(), 1);
+        REQUIRE_EQ(flags.at("shared.seen").safe_get<DxValueType::Integer>(), 1);
+        REQUIRE_EQ(flags.at("flagged.greet_greeted").safe_get<DxValueType::Integer>(), 5);
+
+        // The fork gets its own defaults, even though the data already had the scene set up by someone else
+        run(fork);
+        REQUIRE_EQ(lines, DxVec<DxStr>{ "First visit", "Greeted" });
+        REQUIRE_EQ(forkFlags.size(), 3);
+        REQUIRE_EQ(forkFlags.at("flagged.visit_visits").safe_get<DxValueType::Integer>(), 1);
+    }
+}
+
+TEST_CASE("Interpreter resolves definitions")
+{
+    DxInterpreter interpreter(DxData::fromFile("data/sample.dxb"));
+    int nameLookups = 0;
+    std::string playerName = "Player";
+    interpreter.registerFunction("getPlayerName", [&]
+    {
+        nameLookups++;
+        return playerName;
+    });
+
+    SUBCASE("one at a time")
+    {
+        REQUIRE_EQ(interpreter.definition("menu.button_start"), "Start");
+        REQUIRE_EQ(interpreter.definition("menu.label_welcome"), "Welcome, Player!");
+        REQUIRE_THROWS_AS((void)interpreter.definition("menu.missing"), diannex_exception);
+    }
+
+    SUBCASE("by prefix")
+    {
+        auto [names, values] = interpreter.definitions("menu.");
+        REQUIRE_EQ(names.size(), 4);
+        REQUIRE_EQ(values.size(), 4);
+        REQUIRE_EQ(names[0], "menu.button_continue");
+        REQUIRE_EQ(values[0], "Continue");
+        REQUIRE_EQ(names[3], "menu.label_welcome");
+        REQUIRE_EQ(values[3], "Welcome, Player!");
+
+        REQUIRE(interpreter.definitions("menu.button_").names.size() == 3);
+        REQUIRE(interpreter.definitions("nothing.").names.empty());
+    }
+
+    SUBCASE("by handle")
+    {
+        auto quit = interpreter.definitionId("menu.button_quit");
+        auto welcome = interpreter.definitionId("menu.label_welcome");
+        REQUIRE_EQ(interpreter.definition(quit), "Quit");
+        REQUIRE_EQ(interpreter.definition(welcome), "Welcome, Player!");
+        REQUIRE_EQ(interpreter.definition(welcome), interpreter.definition("menu.label_welcome"));
+    }
+
+    SUBCASE("only re-evaluated when an input changes")
+    {
+        REQUIRE_EQ(interpreter.definition("menu.label_welcome"), "Welcome, Player!");
+        REQUIRE_EQ(interpreter.definition("menu.label_welcome"), "Welcome, Player!");
+        REQUIRE_EQ(nameLookups, 1);
+
+        playerName = "Susie";
+        interpreter.invalidateGlobal("getPlayerName");
+        interpreter.invalidateNative("somethingElse");
+        REQUIRE_EQ(interpreter.definition("menu.label_welcome"), "Welcome, Player!");
+        REQUIRE_EQ(nameLookups, 1);
+
+        interpreter.invalidateNative("getPlayerName");
+        REQUIRE_EQ(interpreter.definition("menu.label_welcome"), "Welcome, Susie!");
+        REQUIRE_EQ(nameLookups, 2);
+
+        playerName = "Kris";
+        interpreter.invalidateDefinitions();
+        REQUIRE_EQ(interpreter.definitions("menu.").values[3], "Welcome, Kris!");
+        REQUIRE_EQ(nameLookups, 3);
+    }
+
+    SUBCASE("only re-evaluated when a global it reads changes")
+    {
+        DxInterpreter status(DxData::fromFile("data/values.dxb"));
+        int gold = 10;
+        int goldLookups = 0;
+        status.variableGetHandler([&](DxStrRef name)
+                                  {
+                                      REQUIRE_EQ(name, "gold");
+                                      goldLookups++;
+                                      return DxValue{ gold, DxValueType::Integer };
+                                  });
+
+        REQUIRE_EQ(status.definition("status.label_gold"), "Gold: 10");
+        REQUIRE_EQ(status.definition("status.label_gold"), "Gold: 10");
+        REQUIRE_EQ(goldLookups, 1);
+
+        gold = 25;
+        status.invalidateGlobal("silver");
+        status.invalidateNative("gold");
+        REQUIRE_EQ(status.definition("status.label_gold"), "Gold: 10");
+        REQUIRE_EQ(goldLookups, 1);
+
+        status.invalidateGlobal("gold");
+        REQUIRE_EQ(status.definition("status.label_gold"), "Gold: 25");
+        REQUIRE_EQ(goldLookups, 2);
+    }
+}
+
+TEST_CASE("Explorer walks every branch of the sample scene")
+{
+    DxExplorer explorer(DxData::fromFile("data/sample.dxb"), { .threadCount = 2 });
+    auto report = explorer.explore();
+
+    REQUIRE_EQ(report.scenes.size(), 1);
+    REQUIRE_EQ(report.scenes[0], "area0.intro");
+    REQUIRE(report.deadBranches.empty());
+
+    size_t completed = 0;
+    for (const auto& path: report.paths)
+    {
+        REQUIRE_NE(path.end, DxPathEnd::Error);
+        REQUIRE_NE(path.end, DxPathEnd::InstructionLimit);
+        if (path.end == DxPathEnd::SceneEnd)
+            completed++;
+    }
+    REQUIRE_GE(completed, 1);
+
+    // Both answers to the question and both lines of the choose statement must be reachable
+    REQUIRE_GE(report.reachableText.size(), 12);
+}
+
+TEST_CASE("Explorer ends paths at choices with nothing left to pick")
+{
+    DxExplorer explorer(DxData::fromFile("data/dead_ends.dxb"), { .threadCount = 2 });
+    auto report = explorer.explore();
+
+    REQUIRE_EQ(report.scenes.size(), 2);
+    REQUIRE_EQ(report.paths.size(), 2);
+    DxVec<DxStr> errors;
+    for (const auto& path: report.paths)
+    {
+        REQUIRE_EQ(path.end, DxPathEnd::Error);
+        REQUIRE(path.decisions.empty());
+        errors.push_back(path.error);
+    }
+    std::sort(errors.begin(), errors.end());
+    REQUIRE_EQ(errors, DxVec<DxStr>{ "Choice statement has no choices to present", "No entries for choose statement" });
+    REQUIRE_EQ(report.deadBranches.size(), 3);
+}